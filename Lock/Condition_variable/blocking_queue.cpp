@@ -0,0 +1,595 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <cassert>
+using namespace std;
+
+// g++ .\blocking_queue.cpp -std=c++17 -O2 -pthread
+
+/*
+    producer_consumer.cpp 的问题：
+        1. 生产者和消费者共用一个条件变量，每次 push/pop 后都 notify_all，
+           所有等待者（包括同类线程）都被唤醒去抢锁，绝大多数醒来后发现条件不满足又睡回去（惊群）；
+        2. 消费者靠读到魔数 4 退出，两个生产者各自产生一个 4，
+           先读到的消费者退出后，另一个消费者可能读到剩下的 4 之前的数据后一直等下去，也可能提前退出留下数据。
+    blocking_queue：
+        not_full/not_empty 两个条件变量，生产者只唤醒消费者、消费者只唤醒生产者；
+        记录每个条件变量上的等待者数量，只在有等待者时 notify_one，没人等时不做系统调用；
+        close()：不再接受新元素并唤醒所有等待者，消费者把剩余元素取完后 pop 返回 false，退出无需魔数；
+        push_bulk/pop_bulk：一次持锁搬运一批元素，小消息高频率时锁的获取次数按批大小成比例减少；
+        高/低水位背压：队列深度达到高水位后生产者阻塞，直到消费者把深度降到低水位才整体放行，
+            避免队列在满/不满之间来回抖动、每取一个元素就唤醒一次生产者。
+*/
+
+enum class queue_status { success, timeout, closed };
+
+// 队列运行状态的快照
+struct queue_stats {
+    size_t depth;               // 当前元素个数
+    uint64_t pushed;            // 累计入队元素数
+    uint64_t popped;            // 累计出队元素数
+    uint64_t wakeups;           // 等待者被唤醒的总次数（含虚假唤醒）
+    double producer_blocked_ms; // 生产者累计阻塞时间（所有生产者之和）
+    double consumer_idle_ms;    // 消费者累计空等时间（所有消费者之和）
+};
+
+template<typename T>
+class blocking_queue
+{
+private:
+    mutable mutex mtx;
+    condition_variable not_full;
+    condition_variable not_empty;
+    deque<T> items;
+    const size_t high_watermark; // 深度达到此值后生产者阻塞（即容量）
+    const size_t low_watermark;  // 阻塞后深度降到此值才放行生产者
+    bool throttled = false;      // 是否处于背压状态
+    size_t full_waiters = 0;     // 在 not_full 上等待的生产者数
+    size_t empty_waiters = 0;    // 在 not_empty 上等待的消费者数
+    bool closed = false;
+
+    /*
+        统计计数器：在持锁时更新（relaxed 即可），读取时不需要加锁，
+        监控线程可以随时调用 stats() 而不与生产者/消费者争锁。
+    */
+    atomic<size_t> depth{0};
+    atomic<uint64_t> pushed{0}, popped{0}, wakeup_count{0};
+    atomic<int64_t> producer_blocked_ns{0}, consumer_idle_ns{0};
+
+    using clock = chrono::steady_clock;
+
+    static void add_elapsed(atomic<int64_t>& counter, clock::time_point since) {
+        counter.fetch_add(chrono::duration_cast<chrono::nanoseconds>(clock::now() - since).count(),
+                          memory_order_relaxed);
+    }
+
+    bool can_push() const { return !throttled || closed; }
+
+    // 入队 n 个元素后更新计数，返回需要唤醒的消费者数（不超过等待者数和新元素数）
+    size_t after_push(size_t n) {
+        if(items.size() >= high_watermark)
+            throttled = true;
+        depth.store(items.size(), memory_order_relaxed);
+        pushed.fetch_add(n, memory_order_relaxed);
+        return min(empty_waiters, n);
+    }
+
+    /*
+        出队后更新计数并在解锁后唤醒生产者：
+            背压期间不唤醒；解除背压（深度降到低水位）后，唤醒个数不超过空位数，
+            默认水位（low = high - 1）下每次只有一个空位，退化为 notify_one。
+            解除背压后仍有生产者在等（上次只唤醒了一部分）时，之后的每次出队继续唤醒，
+            否则消费者把队列取空后这些生产者就再也没有机会被唤醒。
+    */
+    void after_pop(unique_lock<mutex>& lock, size_t n) {
+        if(throttled && items.size() <= low_watermark)
+            throttled = false;
+        size_t wake = throttled ? 0 : min(full_waiters, high_watermark - items.size());
+        depth.store(items.size(), memory_order_relaxed);
+        popped.fetch_add(n, memory_order_relaxed);
+        lock.unlock();
+        notify(not_full, wake); // 解锁后再通知，被唤醒的线程不必立刻阻塞在锁上
+    }
+
+    static void notify(condition_variable& cv, size_t n) {
+        for(size_t i = 0; i < n; i++)
+            cv.notify_one();
+    }
+
+    // 等待可以入队（或队列关闭），统计阻塞时间
+    void wait_not_full(unique_lock<mutex>& lock) {
+        if(can_push())
+            return;
+        auto start = clock::now();
+        while(!can_push()) {
+            ++full_waiters;
+            not_full.wait(lock);
+            --full_waiters;
+            wakeup_count.fetch_add(1, memory_order_relaxed);
+        }
+        add_elapsed(producer_blocked_ns, start);
+    }
+
+    // 等待队列非空（或队列关闭），统计空等时间
+    void wait_not_empty(unique_lock<mutex>& lock) {
+        if(!items.empty() || closed)
+            return;
+        auto start = clock::now();
+        while(items.empty() && !closed) {
+            ++empty_waiters;
+            not_empty.wait(lock);
+            --empty_waiters;
+            wakeup_count.fetch_add(1, memory_order_relaxed);
+        }
+        add_elapsed(consumer_idle_ns, start);
+    }
+
+    // 取出队头；调用前已持有锁且队列非空
+    T take(unique_lock<mutex>& lock) {
+        T value = move(items.front());
+        items.pop_front();
+        after_pop(lock, 1);
+        return value;
+    }
+
+public:
+    // 容量为 capacity，低水位为 capacity - 1：每取走一个元素就放行生产者，与普通有界队列相同
+    explicit blocking_queue(size_t capacity) : blocking_queue(capacity, capacity - 1) {}
+
+    /*
+    * @brief 带高/低水位的有界队列
+    * @param high：深度达到 high 后生产者阻塞（即容量）
+    *        low：生产者阻塞后，深度降到 low 才放行，要求 low < high
+    */
+    blocking_queue(size_t high, size_t low) : high_watermark(high), low_watermark(low) {
+        assert(high > 0 && low < high);
+    }
+
+    blocking_queue(const blocking_queue&) = delete;
+    blocking_queue& operator=(const blocking_queue&) = delete;
+
+    /*
+    * @brief 阻塞入队：处于背压状态时等待
+    * @return 队列已关闭返回 false（元素未入队）
+    */
+    bool push(T value) {
+        unique_lock<mutex> lock(mtx);
+        wait_not_full(lock);
+        if(closed)
+            return false;
+        items.push_back(move(value));
+        size_t wake = after_push(1);
+        lock.unlock();
+        notify(not_empty, wake);
+        return true;
+    }
+
+    /*
+    * @brief 批量入队：每次持锁放入尽可能多的元素（直到高水位），放不下时等待后继续
+    * @return 实际入队的个数，队列中途关闭时小于输入个数
+    */
+    template<typename InputIt>
+    size_t push_bulk(InputIt first, InputIt last) {
+        size_t total = 0;
+        while(first != last) {
+            unique_lock<mutex> lock(mtx);
+            wait_not_full(lock);
+            if(closed)
+                break;
+            size_t n = 0;
+            for(; first != last && items.size() < high_watermark; ++first, ++n)
+                items.push_back(move(*first));
+            total += n;
+            size_t wake = after_push(n);
+            lock.unlock();
+            notify(not_empty, wake);
+        }
+        return total;
+    }
+
+    /*
+    * @brief 阻塞出队：队列空时等待
+    * @return 队列已关闭且已取空时返回 false
+    */
+    bool pop(T& value) {
+        unique_lock<mutex> lock(mtx);
+        wait_not_empty(lock);
+        if(items.empty())
+            return false;
+        value = take(lock);
+        return true;
+    }
+
+    /*
+    * @brief 批量出队：队列空时等待，之后一次持锁取出至多 max_n 个元素写入 out
+    * @return 取出的个数；队列已关闭且已取空时返回 0
+    */
+    template<typename OutputIt>
+    size_t pop_bulk(OutputIt out, size_t max_n) {
+        unique_lock<mutex> lock(mtx);
+        wait_not_empty(lock);
+        size_t n = 0;
+        for(; n < max_n && !items.empty(); ++n) {
+            *out++ = move(items.front());
+            items.pop_front();
+        }
+        if(n)
+            after_pop(lock, n);
+        return n;
+    }
+
+    // 限时出队：超时返回 timeout，已关闭且取空返回 closed
+    template<typename Rep, typename Period>
+    queue_status pop_for(T& value, const chrono::duration<Rep, Period>& timeout) {
+        auto start = clock::now();
+        auto deadline = start + timeout;
+        unique_lock<mutex> lock(mtx);
+        bool waited = false;
+        while(items.empty() && !closed) {
+            waited = true;
+            ++empty_waiters;
+            cv_status status = not_empty.wait_until(lock, deadline);
+            --empty_waiters;
+            wakeup_count.fetch_add(1, memory_order_relaxed);
+            if(status == cv_status::timeout && items.empty() && !closed) {
+                add_elapsed(consumer_idle_ns, start);
+                return queue_status::timeout;
+            }
+        }
+        if(waited)
+            add_elapsed(consumer_idle_ns, start);
+        if(items.empty())
+            return queue_status::closed;
+        value = take(lock);
+        return queue_status::success;
+    }
+
+    bool try_pop(T& value) {
+        unique_lock<mutex> lock(mtx);
+        if(items.empty())
+            return false;
+        value = take(lock);
+        return true;
+    }
+
+    // 关闭队列：之后的 push 失败，pop 取完剩余元素后返回 false；唤醒所有等待者
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    bool is_closed() const {
+        lock_guard<mutex> lock(mtx);
+        return closed;
+    }
+
+    // 以下读取都不加锁：各计数器分别是某一时刻的值，彼此之间不保证一致
+    size_t size() const {
+        return depth.load(memory_order_relaxed);
+    }
+
+    size_t wakeups() const {
+        return wakeup_count.load(memory_order_relaxed);
+    }
+
+    queue_stats stats() const {
+        return {
+            depth.load(memory_order_relaxed),
+            pushed.load(memory_order_relaxed),
+            popped.load(memory_order_relaxed),
+            wakeup_count.load(memory_order_relaxed),
+            producer_blocked_ns.load(memory_order_relaxed) / 1e6,
+            consumer_idle_ns.load(memory_order_relaxed) / 1e6,
+        };
+    }
+};
+
+// 用 blocking_queue 改写 producer_consumer.cpp：两个生产者各产生 5 个数据，生产者结束后关闭队列
+void demo_producer_consumer() {
+    blocking_queue<int> q(10);
+    mutex print_mutex;
+    thread producers[2], consumers[2];
+    for(int id = 0; id < 2; ++id) {
+        producers[id] = thread([&, id]{
+            for(int i = 0; i < 5; ++i) {
+                this_thread::sleep_for(chrono::milliseconds(10)); // 模拟数据生成耗时
+                q.push(i);
+                lock_guard<mutex> lock(print_mutex);
+                cout << "Producer " << id << " produced " << i << endl;
+            }
+        });
+        consumers[id] = thread([&, id]{
+            int val;
+            while(q.pop(val)) { // 队列关闭且取空后退出
+                lock_guard<mutex> lock(print_mutex);
+                cout << "Consumer " << id << " consumed " << val << endl;
+            }
+        });
+    }
+    for(auto& t : producers) t.join();
+    q.close();
+    for(auto& t : consumers) t.join();
+}
+
+void test_blocking_queue() {
+    blocking_queue<int> q(2);
+    int value;
+    assert(!q.try_pop(value));
+    assert(q.pop_for(value, chrono::milliseconds(10)) == queue_status::timeout);
+
+    // 队列满时 push 阻塞，直到消费者取走一个
+    assert(q.push(1) && q.push(2));
+    thread producer([&]{ assert(q.push(3)); });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    assert(q.size() == 2);
+    assert(q.pop(value) && value == 1);
+    producer.join();
+    assert(q.size() == 2);
+
+    // 关闭后：push 失败，剩余元素仍可取出，取空后 pop 返回 false
+    q.close();
+    assert(!q.push(4));
+    assert(q.pop(value) && value == 2);
+    assert(q.pop_for(value, chrono::seconds(1)) == queue_status::success && value == 3);
+    assert(!q.pop(value));
+    assert(q.pop_for(value, chrono::seconds(1)) == queue_status::closed);
+
+    // close 唤醒阻塞中的消费者
+    blocking_queue<int> empty_q(4);
+    thread consumer([&]{
+        int v;
+        assert(!empty_q.pop(v));
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    empty_q.close();
+    consumer.join();
+    cout << "Blocking queue test passed.\n";
+}
+
+// 批量操作、水位与统计计数
+void test_bulk_and_watermarks() {
+    blocking_queue<int> q(8, 4); // 高水位 8，低水位 4
+    vector<int> in = {1, 2, 3, 4, 5, 6};
+    assert(q.push_bulk(in.begin(), in.end()) == 6);
+    assert(q.size() == 6);
+
+    vector<int> out;
+    assert(q.pop_bulk(back_inserter(out), 4) == 4);
+    assert((out == vector<int>{1, 2, 3, 4}));
+
+    // 填到高水位后生产者阻塞，取到低水位以下才放行
+    assert(q.push_bulk(in.begin(), in.end()) == 6); // 深度 8
+    atomic<bool> pushed(false);
+    thread producer([&]{ q.push(100); pushed = true; });
+    int value;
+    for(int i = 0; i < 3; i++) { // 深度 8 -> 5，仍高于低水位
+        assert(q.pop(value));
+        this_thread::sleep_for(chrono::milliseconds(10));
+        assert(!pushed);
+    }
+    assert(q.pop(value)); // 深度 4，解除背压
+    producer.join();
+    assert(pushed && q.size() == 5);
+
+    queue_stats st = q.stats();
+    assert(st.pushed == 13 && st.popped == 8 && st.depth == 5);
+    assert(st.producer_blocked_ms > 0);
+
+    // 关闭后 pop_bulk 取出剩余元素，之后返回 0；push_bulk 返回 0
+    q.close();
+    out.clear();
+    assert(q.pop_bulk(back_inserter(out), 100) == 5);
+    assert(out.back() == 100);
+    assert(q.pop_bulk(back_inserter(out), 100) == 0);
+    assert(q.push_bulk(in.begin(), in.end()) == 0);
+    cout << "Bulk and watermark test passed.\n";
+}
+
+// 多生产者多消费者：关闭后每个元素恰好被取出一次
+void test_blocking_queue_shutdown() {
+    const int kProducers = 3, kConsumers = 4, kItems = 20000;
+    blocking_queue<int> q(16);
+    vector<atomic<int>> seen(kProducers * kItems);
+    vector<thread> producers, consumers;
+    for(int p = 0; p < kProducers; p++)
+        producers.emplace_back([&, p]{
+            for(int i = 0; i < kItems; i++) q.push(p * kItems + i);
+        });
+    for(int c = 0; c < kConsumers; c++)
+        consumers.emplace_back([&]{
+            int v;
+            while(q.pop(v)) seen[v]++;
+        });
+    for(auto& t : producers) t.join();
+    q.close();
+    for(auto& t : consumers) t.join();
+    for(auto& s : seen)
+        assert(s == 1);
+    cout << "Blocking queue shutdown test passed.\n";
+}
+
+// 原设计：单个条件变量 + notify_all，加上唤醒计数；关闭方式与 blocking_queue 相同，只比较唤醒策略
+template<typename T>
+class notify_all_queue
+{
+    mutex mtx;
+    condition_variable cond;
+    queue<T> items;
+    size_t max_size;
+    bool closed = false;
+    size_t wakeup_count = 0;
+
+public:
+    explicit notify_all_queue(size_t capacity) : max_size(capacity) {}
+
+    bool push(T value) {
+        unique_lock<mutex> lock(mtx);
+        while(items.size() >= max_size && !closed) {
+            cond.wait(lock);
+            ++wakeup_count;
+        }
+        if(closed) return false;
+        items.push(move(value));
+        lock.unlock();
+        cond.notify_all();
+        return true;
+    }
+
+    bool pop(T& value) {
+        unique_lock<mutex> lock(mtx);
+        while(items.empty() && !closed) {
+            cond.wait(lock);
+            ++wakeup_count;
+        }
+        if(items.empty()) return false;
+        value = move(items.front());
+        items.pop();
+        lock.unlock();
+        cond.notify_all();
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+        }
+        cond.notify_all();
+    }
+
+    size_t wakeups() {
+        lock_guard<mutex> lock(mtx);
+        return wakeup_count;
+    }
+};
+
+/*
+    基准测试：生产者放入发送时刻，消费者计算交接延迟（从 push 到 pop 返回），
+    输出每个元素平均引起的唤醒次数和 p50/p99 延迟。
+*/
+template<typename Queue>
+void handoff_stats(const char* name, int producers, int consumers, int items_per_producer, size_t capacity)
+{
+    using clock = chrono::steady_clock;
+    Queue q(capacity);
+    vector<vector<int64_t>> latencies(consumers);
+    vector<thread> threads;
+    auto start = clock::now();
+    for(int c = 0; c < consumers; c++)
+        threads.emplace_back([&, c]{
+            int64_t sent;
+            while(q.pop(sent))
+                latencies[c].push_back(clock::now().time_since_epoch().count() - sent);
+        });
+    vector<thread> producer_threads;
+    for(int p = 0; p < producers; p++)
+        producer_threads.emplace_back([&]{
+            for(int i = 0; i < items_per_producer; i++)
+                q.push(clock::now().time_since_epoch().count());
+        });
+    for(auto& t : producer_threads) t.join();
+    q.close();
+    for(auto& t : threads) t.join();
+    double s = chrono::duration<double>(clock::now() - start).count();
+
+    vector<int64_t> all;
+    for(auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    sort(all.begin(), all.end());
+    double total = static_cast<double>(producers) * items_per_producer;
+    auto pct_us = [&](double p){
+        int64_t ticks = all[min<size_t>(all.size() - 1, static_cast<size_t>(p * all.size()))];
+        return chrono::duration<double, micro>(clock::duration(ticks)).count();
+    };
+    cout << name << "  " << producers << "P/" << consumers << "C"
+         << "  wakeups/item: " << q.wakeups() / total
+         << "  p50: " << pct_us(0.50) << " us  p99: " << pct_us(0.99) << " us"
+         << "  throughput: " << total / s / 1e6 << " M items/s" << endl;
+}
+
+void bench_blocking_queue()
+{
+    const int kItems = 200000;
+    for(int n : {1, 2, 4, 8}) {
+        handoff_stats<notify_all_queue<int64_t>>("notify_all    ", n, n, kItems / n, 10);
+        handoff_stats<blocking_queue<int64_t>>("blocking_queue", n, n, kItems / n, 10);
+    }
+}
+
+/*
+    批量基准：2 个生产者、2 个消费者传递小消息，比较每次持锁搬运 1/16/64 个元素的吞吐量，
+    并由监控线程在不加锁的情况下采样队列深度，输出各项统计。
+*/
+void bench_bulk_operations()
+{
+    const int kProducers = 2, kConsumers = 2, kItems = 1 << 21;
+    for(size_t batch : {1, 16, 64}) {
+        blocking_queue<int> q(1024, 512);
+        atomic<bool> done(false);
+        size_t max_depth = 0;
+        thread monitor([&]{
+            while(!done) {
+                max_depth = max(max_depth, q.stats().depth);
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+        });
+        auto start = chrono::steady_clock::now();
+        vector<thread> producers, consumers;
+        for(int p = 0; p < kProducers; p++)
+            producers.emplace_back([&]{
+                vector<int> buf(batch);
+                for(int i = 0; i < kItems / kProducers; i += static_cast<int>(batch)) {
+                    if(batch == 1) q.push(i);
+                    else q.push_bulk(buf.begin(), buf.end());
+                }
+            });
+        for(int c = 0; c < kConsumers; c++)
+            consumers.emplace_back([&]{
+                vector<int> buf(batch);
+                if(batch == 1) {
+                    int v;
+                    while(q.pop(v)) {}
+                } else {
+                    while(q.pop_bulk(buf.begin(), batch)) {}
+                }
+            });
+        for(auto& t : producers) t.join();
+        q.close();
+        for(auto& t : consumers) t.join();
+        double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        done = true;
+        monitor.join();
+
+        queue_stats st = q.stats();
+        cout << "batch = " << batch
+             << "  throughput: " << st.popped / s / 1e6 << " M items/s"
+             << "  max depth: " << max_depth
+             << "  wakeups: " << st.wakeups
+             << "  producer blocked: " << st.producer_blocked_ms << " ms"
+             << "  consumer idle: " << st.consumer_idle_ms << " ms" << endl;
+    }
+}
+
+int main()
+{
+    demo_producer_consumer();
+    test_blocking_queue();
+    test_bulk_and_watermarks();
+    test_blocking_queue_shutdown();
+    // bench_blocking_queue();
+    // bench_bulk_operations();
+
+    return 0;
+}
\ No newline at end of file
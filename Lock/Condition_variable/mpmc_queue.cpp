@@ -0,0 +1,289 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <utility>
+#include <cstdint>
+#include <string>
+#include <cassert>
+using namespace std;
+
+// g++ .\mpmc_queue.cpp -std=c++20 -O2 -pthread（std::atomic::wait 需要 C++20）
+
+/*
+    有界多生产者多消费者无锁环形队列（Vyukov bounded MPMC queue）
+        每个槽位带一个序号 sequence，生产者/消费者只通过 CAS 抢占全局位置 enqueue_pos/dequeue_pos，
+        再根据槽位序号判断该槽是否可写/可读：
+            sequence == pos       ：槽位空闲，位置 pos 的生产者可以写入
+            sequence == pos + 1   ：槽位已写入，位置 pos 的消费者可以读取
+        读取后把 sequence 设为 pos + 容量，留给下一圈的生产者。
+        每个槽位独占一个缓存行，生产者和消费者的位置计数器也各占一个缓存行，避免伪共享。
+    阻塞版本 push/pop：先自旋重试一小段时间，仍不成功再用 std::atomic::wait 挂起（Linux 上即 futex），
+    并且只在确实有线程挂起时才调用 notify_one，避免 producer_consumer.cpp 中每次 notify_all 的惊群效应。
+*/
+template<typename T>
+class mpmc_queue
+{
+private:
+    struct alignas(64) cell {
+        atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)]; // 元素在这里原地构造
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    static constexpr int SPIN_COUNT = 64; // 挂起前的自旋重试次数
+
+    vector<cell> buffer;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueue_pos{0};
+    alignas(64) atomic<size_t> dequeue_pos{0};
+
+    // 阻塞等待用的事件计数：有等待者时，每次成功 push/pop 加一，等待者在旧值上 wait
+    alignas(64) atomic<uint32_t> push_events{0};
+    atomic<uint32_t> pop_waiters{0};
+    alignas(64) atomic<uint32_t> pop_events{0};
+    atomic<uint32_t> push_waiters{0};
+
+    /*
+        没有等待者时只有一个本核的 seq_cst 栅栏，不写任何共享变量（事件计数只在有人等待时才改）。
+        栅栏与等待者 waiters++ 之后的栅栏构成 Dekker 式配对：要么这里看到 waiters 非零，
+        要么等待者随后的 try_op 看到刚发布的元素，不会丢失唤醒。
+    */
+    static void signal(atomic<uint32_t>& events, atomic<uint32_t>& waiters) {
+        atomic_thread_fence(memory_order_seq_cst);
+        if(waiters.load(memory_order_relaxed) != 0) {
+            events.fetch_add(1);
+            events.notify_one();
+        }
+    }
+
+    // 先自旋，再挂起：try_op 成功即返回
+    template<typename TryOp>
+    static void wait_until(TryOp try_op, atomic<uint32_t>& events, atomic<uint32_t>& waiters) {
+        for(int i = 0; i < SPIN_COUNT; i++) {
+            if(try_op()) return;
+            this_thread::yield();
+        }
+        while(true) {
+            uint32_t seen = events.load();
+            waiters.fetch_add(1);
+            atomic_thread_fence(memory_order_seq_cst);
+            if(try_op()) {
+                waiters.fetch_sub(1);
+                return;
+            }
+            events.wait(seen); // 事件计数变化（有线程完成了一次对侧操作）后返回
+            waiters.fetch_sub(1);
+        }
+    }
+
+public:
+    // capacity 必须是 2 的幂，用位与代替取模
+    explicit mpmc_queue(size_t capacity) : buffer(capacity), mask(capacity - 1) {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        for(size_t i = 0; i < capacity; i++)
+            buffer[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    ~mpmc_queue() {
+        T value;
+        while(try_pop(value)) {}
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // 非阻塞入队：队列满返回 false
+    template<typename U>
+    bool try_push(U&& value) {
+        size_t pos = enqueue_pos.load(memory_order_relaxed);
+        cell* c;
+        while(true) {
+            c = &buffer[pos & mask];
+            size_t seq = c->sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if(diff == 0) {
+                // 槽位空闲，抢占位置 pos；失败时 pos 被更新为最新值，重试
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            } else if(diff < 0) {
+                return false; // 上一圈的元素还没被取走：队列满
+            } else {
+                pos = enqueue_pos.load(memory_order_relaxed); // 被其他生产者抢先，重新读取
+            }
+        }
+        new (c->storage) T(std::forward<U>(value));
+        c->sequence.store(pos + 1, memory_order_release);
+        signal(push_events, pop_waiters);
+        return true;
+    }
+
+    // 非阻塞出队：队列空返回 false
+    bool try_pop(T& value) {
+        size_t pos = dequeue_pos.load(memory_order_relaxed);
+        cell* c;
+        while(true) {
+            c = &buffer[pos & mask];
+            size_t seq = c->sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if(diff == 0) {
+                if(dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            } else if(diff < 0) {
+                return false; // 该位置还没有写入：队列空
+            } else {
+                pos = dequeue_pos.load(memory_order_relaxed);
+            }
+        }
+        value = std::move(*c->ptr());
+        c->ptr()->~T();
+        c->sequence.store(pos + mask + 1, memory_order_release);
+        signal(pop_events, push_waiters);
+        return true;
+    }
+
+    // 阻塞入队：队列满时先自旋，再挂起等待消费者取走元素
+    void push(T value) {
+        wait_until([&]{ return try_push(std::move(value)); }, pop_events, push_waiters);
+    }
+
+    // 阻塞出队：队列空时先自旋，再挂起等待生产者放入元素
+    void pop(T& value) {
+        wait_until([&]{ return try_pop(value); }, push_events, pop_waiters);
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+/*
+    与 producer_consumer.cpp 相同的设计：一把互斥锁、一个条件变量，每次 push/pop 之后 notify_all。
+    封装成类只是为了能在基准测试中按相同的接口对比。
+*/
+template<typename T>
+class mutex_cv_queue
+{
+    queue<T> data_queue;
+    mutex queue_mutex;
+    condition_variable data_cond;
+    size_t max_size;
+
+public:
+    explicit mutex_cv_queue(size_t capacity) : max_size(capacity) {}
+
+    void push(T value) {
+        unique_lock<mutex> lock(queue_mutex);
+        data_cond.wait(lock, [this]{ return data_queue.size() < max_size; });
+        data_queue.push(std::move(value));
+        lock.unlock();
+        data_cond.notify_all();
+    }
+
+    void pop(T& value) {
+        unique_lock<mutex> lock(queue_mutex);
+        data_cond.wait(lock, [this]{ return !data_queue.empty(); });
+        value = std::move(data_queue.front());
+        data_queue.pop();
+        lock.unlock();
+        data_cond.notify_all();
+    }
+};
+
+void test_try_operations() {
+    mpmc_queue<int> q(4);
+    int value;
+    assert(!q.try_pop(value));
+    for(int i = 0; i < 4; i++)
+        assert(q.try_push(i));
+    assert(!q.try_push(4)); // 满
+    for(int i = 0; i < 4; i++) {
+        assert(q.try_pop(value));
+        assert(value == i); // FIFO
+    }
+    assert(!q.try_pop(value));
+
+    // 非平凡类型：析构时释放队列中剩余的元素
+    mpmc_queue<string> s(8);
+    s.push("hello");
+    s.push("world");
+    string str;
+    s.pop(str);
+    assert(str == "hello");
+    cout << "Try operations test passed.\n";
+}
+
+// 多生产者多消费者：每个元素恰好被消费一次
+void test_mpmc() {
+    const int kProducers = 4, kConsumers = 4, kItemsPerProducer = 100000;
+    const int kTotal = kProducers * kItemsPerProducer;
+    mpmc_queue<int> q(64);
+    vector<atomic<int>> seen(kTotal);
+    vector<thread> threads;
+
+    for(int p = 0; p < kProducers; p++)
+        threads.emplace_back([&, p]{
+            for(int i = 0; i < kItemsPerProducer; i++)
+                q.push(p * kItemsPerProducer + i);
+        });
+    for(int c = 0; c < kConsumers; c++)
+        threads.emplace_back([&]{
+            int value;
+            for(int i = 0; i < kTotal / kConsumers; i++) {
+                q.pop(value);
+                seen[value]++;
+            }
+        });
+    for(auto& t : threads) t.join();
+
+    for(auto& s : seen)
+        assert(s == 1);
+    cout << "MPMC test passed.\n";
+}
+
+// n 个生产者、n 个消费者通过队列传递 total 个元素，返回吞吐量（M items/s）
+template<typename Queue>
+double queue_throughput(int n, int total, size_t capacity) {
+    Queue q(capacity);
+    vector<thread> threads;
+    int per_thread = total / n;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < n; i++) {
+        threads.emplace_back([&]{
+            for(int j = 0; j < per_thread; j++) q.push(j);
+        });
+        threads.emplace_back([&]{
+            int value;
+            for(int j = 0; j < per_thread; j++) q.pop(value);
+        });
+    }
+    for(auto& t : threads) t.join();
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return static_cast<double>(per_thread) * n / s / 1e6;
+}
+
+void bench_mpmc_queue() {
+    const int kTotal = 1 << 20;
+    for(size_t capacity : {size_t(10), size_t(1024)}) {
+        // mpmc_queue 容量必须是 2 的幂，容量 10 对应 16
+        size_t pow2 = 1;
+        while(pow2 < capacity) pow2 <<= 1;
+        for(int n = 1; n <= 32; n *= 2) {
+            cout << "capacity = " << capacity << "  producers = consumers = " << n
+                 << "  mutex+cv: " << queue_throughput<mutex_cv_queue<int>>(n, kTotal, capacity) << " M items/s"
+                 << "  mpmc: " << queue_throughput<mpmc_queue<int>>(n, kTotal, pow2) << " M items/s" << endl;
+        }
+    }
+}
+
+int main()
+{
+    test_try_operations();
+    test_mpmc();
+    // bench_mpmc_queue();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,505 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+using namespace std;
+
+// g++ .\priority_queue.cpp -std=c++17 -O2 -pthread
+
+/*
+    producer_consumer.cpp 中的队列是严格 FIFO 的，延迟敏感的请求要排在大批量请求后面。
+    这里提供两种与 blocking_queue 相同生产者/消费者约定（有界、阻塞 push/pop、pop_for、close）的变体：
+        priority_blocking_queue：按优先级分桶，每个优先级一个 FIFO 队列，
+            用一个 64 位掩码记录哪些桶非空，pop 时用 ctz 直接找到最高优先级的非空桶，O(1)；
+        deadline_queue：EDF（最早截止时间优先），按截止时间组成小顶堆，
+            出队时对已过期的元素按策略丢弃（drop）或标记后照常交出（flag）。
+*/
+
+enum class queue_status { success, timeout, closed };
+
+template<typename T>
+class priority_blocking_queue
+{
+private:
+    mutable mutex mtx;
+    condition_variable not_full;
+    condition_variable not_empty;
+    vector<deque<T>> levels;  // levels[0] 优先级最高
+    uint64_t non_empty = 0;   // 第 i 位为 1 表示 levels[i] 非空
+    size_t count = 0;
+    const size_t max_size;
+    size_t full_waiters = 0;
+    size_t empty_waiters = 0;
+    bool closed = false;
+
+    // 取出最高优先级桶的队头；调用前已持有锁且队列非空
+    T take(unique_lock<mutex>& lock, unsigned* priority) {
+        unsigned level = static_cast<unsigned>(__builtin_ctzll(non_empty));
+        deque<T>& q = levels[level];
+        T value = move(q.front());
+        q.pop_front();
+        if(q.empty())
+            non_empty &= ~(uint64_t(1) << level);
+        --count;
+        if(priority) *priority = level;
+        bool wake = full_waiters > 0;
+        lock.unlock();
+        if(wake) not_full.notify_one();
+        return value;
+    }
+
+public:
+    /*
+    * @param num_levels：优先级个数（1~64），优先级 0 最高；只有 1 个级别时就是普通 FIFO 队列
+    *        capacity：所有优先级合计的容量
+    */
+    priority_blocking_queue(unsigned num_levels, size_t capacity) : levels(num_levels), max_size(capacity) {
+        assert(num_levels >= 1 && num_levels <= 64 && capacity > 0);
+    }
+
+    priority_blocking_queue(const priority_blocking_queue&) = delete;
+    priority_blocking_queue& operator=(const priority_blocking_queue&) = delete;
+
+    // 阻塞入队；priority 超出范围时按最低优先级处理；队列已关闭返回 false
+    bool push(T value, unsigned priority) {
+        priority = min<unsigned>(priority, static_cast<unsigned>(levels.size()) - 1);
+        unique_lock<mutex> lock(mtx);
+        while(count >= max_size && !closed) {
+            ++full_waiters;
+            not_full.wait(lock);
+            --full_waiters;
+        }
+        if(closed)
+            return false;
+        levels[priority].push_back(move(value));
+        non_empty |= uint64_t(1) << priority;
+        ++count;
+        bool wake = empty_waiters > 0;
+        lock.unlock();
+        if(wake) not_empty.notify_one();
+        return true;
+    }
+
+    /*
+    * @brief 阻塞出队：取出最高优先级的元素，同一优先级内 FIFO
+    * @param priority：非空时写入取出元素的优先级
+    * @return 队列已关闭且已取空时返回 false
+    */
+    bool pop(T& value, unsigned* priority = nullptr) {
+        unique_lock<mutex> lock(mtx);
+        while(count == 0 && !closed) {
+            ++empty_waiters;
+            not_empty.wait(lock);
+            --empty_waiters;
+        }
+        if(count == 0)
+            return false;
+        value = take(lock, priority);
+        return true;
+    }
+
+    template<typename Rep, typename Period>
+    queue_status pop_for(T& value, const chrono::duration<Rep, Period>& timeout, unsigned* priority = nullptr) {
+        auto deadline = chrono::steady_clock::now() + timeout;
+        unique_lock<mutex> lock(mtx);
+        while(count == 0 && !closed) {
+            ++empty_waiters;
+            cv_status status = not_empty.wait_until(lock, deadline);
+            --empty_waiters;
+            if(status == cv_status::timeout && count == 0 && !closed)
+                return queue_status::timeout;
+        }
+        if(count == 0)
+            return queue_status::closed;
+        value = take(lock, priority);
+        return queue_status::success;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(mtx);
+        return count;
+    }
+};
+
+// EDF 队列对已过期元素的处理方式
+enum class expiry_policy {
+    drop, // 直接丢弃，不交给消费者
+    flag  // 照常交给消费者，但 expired 置为 true，由消费者决定如何处理（例如返回超时错误）
+};
+
+template<typename T>
+struct deadline_item {
+    T value;
+    chrono::steady_clock::time_point deadline;
+    bool expired = false;
+};
+
+template<typename T>
+class deadline_queue
+{
+private:
+    using clock = chrono::steady_clock;
+
+    struct entry {
+        T value;
+        clock::time_point deadline;
+        uint64_t seq; // 截止时间相同时按入队顺序
+    };
+    struct later {
+        bool operator()(const entry& a, const entry& b) const {
+            return a.deadline != b.deadline ? a.deadline > b.deadline : a.seq > b.seq;
+        }
+    };
+
+    mutable mutex mtx;
+    condition_variable not_full;
+    condition_variable not_empty;
+    vector<entry> heap; // 以 later 为比较器的堆，堆顶截止时间最早
+    uint64_t next_seq = 0;
+    const size_t max_size;
+    const expiry_policy policy;
+    size_t full_waiters = 0;
+    size_t empty_waiters = 0;
+    size_t dropped_count = 0;
+    bool closed = false;
+
+    entry pop_top() {
+        pop_heap(heap.begin(), heap.end(), later());
+        entry e = move(heap.back());
+        heap.pop_back();
+        return e;
+    }
+
+    // drop 策略：丢弃堆顶所有已过期的元素（过期元素的截止时间最早，一定集中在堆顶），返回丢弃个数
+    size_t drop_expired(clock::time_point now) {
+        size_t n = 0;
+        while(!heap.empty() && heap.front().deadline < now) {
+            pop_top();
+            ++n;
+        }
+        dropped_count += n;
+        return n;
+    }
+
+public:
+    deadline_queue(size_t capacity, expiry_policy p) : max_size(capacity), policy(p) {
+        assert(capacity > 0);
+        heap.reserve(capacity);
+    }
+
+    deadline_queue(const deadline_queue&) = delete;
+    deadline_queue& operator=(const deadline_queue&) = delete;
+
+    bool push(T value, clock::time_point deadline) {
+        unique_lock<mutex> lock(mtx);
+        while(heap.size() >= max_size && !closed) {
+            ++full_waiters;
+            not_full.wait(lock);
+            --full_waiters;
+        }
+        if(closed)
+            return false;
+        heap.push_back({move(value), deadline, next_seq++});
+        push_heap(heap.begin(), heap.end(), later());
+        bool wake = empty_waiters > 0;
+        lock.unlock();
+        if(wake) not_empty.notify_one();
+        return true;
+    }
+
+    /*
+    * @brief 阻塞出队：取出截止时间最早的元素
+    *        drop 策略下跳过已过期的元素（可能因此继续等待），flag 策略下交出并置 expired
+    * @return 队列已关闭且已取空时返回 false
+    */
+    bool pop(deadline_item<T>& out) {
+        unique_lock<mutex> lock(mtx);
+        size_t freed = 0;
+        clock::time_point now;
+        while(true) {
+            now = clock::now(); // 丢弃检查和 expired 标志使用同一个时刻，drop 策略下交出的元素一定未过期
+            if(policy == expiry_policy::drop)
+                freed += drop_expired(now);
+            if(!heap.empty() || closed)
+                break;
+            if(freed && full_waiters) {
+                // 丢弃的元素腾出了空间，先放行生产者再等待
+                lock.unlock();
+                not_full.notify_all();
+                lock.lock();
+                freed = 0;
+                continue;
+            }
+            ++empty_waiters;
+            not_empty.wait(lock);
+            --empty_waiters;
+        }
+        if(heap.empty())
+            return false;
+        entry e = pop_top();
+        bool expired = policy == expiry_policy::flag && e.deadline < now;
+        bool wake = full_waiters > 0;
+        lock.unlock();
+        if(wake) {
+            if(freed) not_full.notify_all();
+            else not_full.notify_one();
+        }
+        out.deadline = e.deadline;
+        out.expired = expired;
+        out.value = move(e.value);
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(mtx);
+        return heap.size();
+    }
+
+    // drop 策略下累计丢弃的元素个数
+    size_t dropped() const {
+        lock_guard<mutex> lock(mtx);
+        return dropped_count;
+    }
+};
+
+void test_priority_queue() {
+    priority_blocking_queue<int> q(3, 16);
+    q.push(1, 2);
+    q.push(2, 1);
+    q.push(3, 0);
+    q.push(4, 2);
+    q.push(5, 0);
+    q.push(6, 99); // 超出范围按最低优先级
+    int value;
+    unsigned prio;
+    int expect[] = {3, 5, 2, 1, 4, 6};
+    unsigned expect_prio[] = {0, 0, 1, 2, 2, 2};
+    for(int i = 0; i < 6; i++) {
+        assert(q.pop(value, &prio));
+        assert(value == expect[i] && prio == expect_prio[i]);
+    }
+    assert(q.pop_for(value, chrono::milliseconds(5)) == queue_status::timeout);
+
+    // 关闭后取完剩余元素，pop 返回 false
+    q.push(7, 1);
+    q.close();
+    assert(!q.push(8, 0));
+    assert(q.pop(value) && value == 7);
+    assert(!q.pop(value));
+    assert(q.pop_for(value, chrono::seconds(1)) == queue_status::closed);
+    cout << "Priority queue test passed.\n";
+}
+
+void test_deadline_queue() {
+    using clock = chrono::steady_clock;
+    auto now = clock::now();
+    deadline_item<int> item;
+
+    // flag：按截止时间顺序交出，过期的做标记
+    deadline_queue<int> flag_q(16, expiry_policy::flag);
+    flag_q.push(1, now + chrono::seconds(30));
+    flag_q.push(2, now - chrono::seconds(1)); // 已过期
+    flag_q.push(3, now + chrono::seconds(10));
+    assert(flag_q.pop(item) && item.value == 2 && item.expired);
+    assert(flag_q.pop(item) && item.value == 3 && !item.expired);
+    assert(flag_q.pop(item) && item.value == 1 && !item.expired);
+
+    // drop：过期的元素被丢弃并计数
+    deadline_queue<int> drop_q(16, expiry_policy::drop);
+    drop_q.push(1, now - chrono::seconds(2));
+    drop_q.push(2, now + chrono::seconds(30));
+    drop_q.push(3, now - chrono::seconds(1));
+    assert(drop_q.pop(item) && item.value == 2 && !item.expired);
+    assert(drop_q.dropped() == 2);
+
+    // 只剩过期元素时，消费者继续等待直到有新元素或队列关闭
+    drop_q.push(4, now - chrono::seconds(1));
+    thread consumer([&]{
+        deadline_item<int> it;
+        assert(drop_q.pop(it) && it.value == 5);
+        assert(!drop_q.pop(it));
+    });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    drop_q.push(5, clock::now() + chrono::seconds(30));
+    this_thread::sleep_for(chrono::milliseconds(10));
+    drop_q.close();
+    consumer.join();
+    assert(drop_q.dropped() == 3);
+    cout << "Deadline queue test passed.\n";
+}
+
+// 多生产者多消费者：每个元素恰好被取出一次
+void test_priority_queue_concurrent() {
+    const int kProducers = 4, kConsumers = 4, kItems = 20000;
+    priority_blocking_queue<int> q(4, 32);
+    vector<atomic<int>> seen(kProducers * kItems);
+    vector<thread> producers, consumers;
+    for(int p = 0; p < kProducers; p++)
+        producers.emplace_back([&, p]{
+            for(int i = 0; i < kItems; i++)
+                q.push(p * kItems + i, static_cast<unsigned>(i % 4));
+        });
+    for(int c = 0; c < kConsumers; c++)
+        consumers.emplace_back([&]{
+            int v;
+            while(q.pop(v)) seen[v]++;
+        });
+    for(auto& t : producers) t.join();
+    q.close();
+    for(auto& t : consumers) t.join();
+    for(auto& s : seen)
+        assert(s == 1);
+    cout << "Priority queue concurrent test passed.\n";
+}
+
+// 模拟处理一个请求：忙等 us 微秒
+void busy_work(int us) {
+    auto until = chrono::steady_clock::now() + chrono::microseconds(us);
+    while(chrono::steady_clock::now() < until) {}
+}
+
+struct request {
+    chrono::steady_clock::time_point sent;
+    bool urgent;
+};
+
+/*
+    混合负载基准：10% 的请求是延迟敏感的高优先级请求，其余为大批量请求，
+    消费者处理每个请求耗时约 2us，生产者发送速度略高于处理能力，使队列保持积压。
+    对比 num_levels = 1（即 FIFO）和分桶优先级队列下高优先级请求的 p50/p99 排队延迟。
+*/
+void priority_latency(unsigned num_levels)
+{
+    using clock = chrono::steady_clock;
+    const int kProducers = 2, kConsumers = 2, kPerProducer = 50000;
+    priority_blocking_queue<request> q(num_levels, 256);
+    vector<vector<double>> urgent_us(kConsumers), bulk_us(kConsumers);
+    vector<thread> producers, consumers;
+    for(int c = 0; c < kConsumers; c++)
+        consumers.emplace_back([&, c]{
+            request r;
+            while(q.pop(r)) {
+                double us = chrono::duration<double, micro>(clock::now() - r.sent).count();
+                (r.urgent ? urgent_us[c] : bulk_us[c]).push_back(us);
+                busy_work(2);
+            }
+        });
+    for(int p = 0; p < kProducers; p++)
+        producers.emplace_back([&, p]{
+            mt19937 rng(p);
+            for(int i = 0; i < kPerProducer; i++) {
+                bool urgent = rng() % 10 == 0;
+                q.push({clock::now(), urgent}, urgent ? 0 : 1);
+            }
+        });
+    for(auto& t : producers) t.join();
+    q.close();
+    for(auto& t : consumers) t.join();
+
+    auto report = [](const char* name, vector<vector<double>>& parts) {
+        vector<double> all;
+        for(auto& p : parts) all.insert(all.end(), p.begin(), p.end());
+        sort(all.begin(), all.end());
+        auto pct = [&](double p){ return all[min<size_t>(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+        cout << "  " << name << " p50: " << pct(0.50) << " us  p99: " << pct(0.99) << " us";
+    };
+    cout << (num_levels == 1 ? "FIFO     " : "priority ");
+    report("urgent", urgent_us);
+    report("bulk", bulk_us);
+    cout << endl;
+}
+
+/*
+    EDF 基准：请求的截止时间随机为发送后 200us~20ms，
+    对比 FIFO（按到达顺序处理，统计超时交出的比例）与 EDF drop（过期即丢弃）。
+*/
+void edf_deadline_misses()
+{
+    using clock = chrono::steady_clock;
+    const int kItems = 100000;
+    mt19937 rng(7);
+    vector<chrono::microseconds> budgets(kItems);
+    for(auto& b : budgets)
+        b = chrono::microseconds(200 + rng() % 20000);
+
+    // FIFO：所有请求同一优先级
+    {
+        priority_blocking_queue<pair<clock::time_point, clock::time_point>> q(1, 256);
+        atomic<int> late(0);
+        thread consumer([&]{
+            pair<clock::time_point, clock::time_point> r;
+            while(q.pop(r)) {
+                if(r.second < clock::now()) late++;
+                busy_work(2);
+            }
+        });
+        for(int i = 0; i < kItems; i++) {
+            auto now = clock::now();
+            q.push({now, now + budgets[i]}, 0);
+        }
+        q.close();
+        consumer.join();
+        cout << "FIFO      late: " << late << " / " << kItems << endl;
+    }
+    {
+        deadline_queue<int> q(256, expiry_policy::drop);
+        atomic<int> late(0);
+        thread consumer([&]{
+            deadline_item<int> item;
+            while(q.pop(item)) {
+                // drop 策略不设置 expired，和 FIFO 一样在取出时与截止时间比较
+                if(item.deadline < clock::now()) late++;
+                busy_work(2);
+            }
+        });
+        for(int i = 0; i < kItems; i++)
+            q.push(i, clock::now() + budgets[i]);
+        q.close();
+        consumer.join();
+        cout << "EDF drop  late: " << late << "  dropped: " << q.dropped() << " / " << kItems << endl;
+    }
+}
+
+void bench_priority_queue()
+{
+    priority_latency(1);
+    priority_latency(2);
+    edf_deadline_misses();
+}
+
+int main()
+{
+    test_priority_queue();
+    test_deadline_queue();
+    test_priority_queue_concurrent();
+    // bench_priority_queue();
+
+    return 0;
+}
\ No newline at end of file
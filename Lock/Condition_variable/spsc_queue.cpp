@@ -0,0 +1,379 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+using namespace std;
+
+// g++ .\spsc_queue.cpp -std=c++17 -O2 -pthread
+
+/*
+    单生产者单消费者（SPSC）环形队列：
+        只有生产者写 tail、只有消费者写 head，两者都不需要 CAS，push/pop 都是 wait-free 的；
+        生产者和消费者的数据分别放在不同的缓存行，互不干扰（避免伪共享）；
+        缓存对方的索引：生产者保存一份 head 的副本 head_cache，只有副本显示队列已满时才去读真正的 head，
+            消费者同理缓存 tail。大多数操作只访问自己的缓存行，跨核的缓存行传输大幅减少；
+        批量提交：push_bulk/pop_bulk 先写入/读出多个元素，最后只发布一次索引（一次 release store）。
+    容量必须是 2 的幂，下标用位与取模；head/tail 单调递增，不回绕，差值即为元素个数。
+*/
+template<typename T>
+class spsc_queue
+{
+private:
+    vector<T> buffer;
+    const size_t mask;
+
+    // 生产者缓存行
+    alignas(64) atomic<size_t> tail{0};
+    size_t head_cache = 0;
+    // 消费者缓存行
+    alignas(64) atomic<size_t> head{0};
+    size_t tail_cache = 0;
+
+    // 生产者视角的剩余空间，缓存值不够 want 个时才刷新 head_cache
+    size_t free_slots(size_t t, size_t want) {
+        size_t cap = mask + 1;
+        if(cap - (t - head_cache) < want)
+            head_cache = head.load(memory_order_acquire);
+        return cap - (t - head_cache);
+    }
+
+    // 消费者视角的可读元素数，缓存值不够 want 个时才刷新 tail_cache
+    size_t ready_slots(size_t h, size_t want) {
+        if(tail_cache - h < want)
+            tail_cache = tail.load(memory_order_acquire);
+        return tail_cache - h;
+    }
+
+public:
+    explicit spsc_queue(size_t capacity) : buffer(capacity), mask(capacity - 1) {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+    }
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    // 只能由生产者线程调用；队列满返回 false
+    bool try_push(const T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if(free_slots(t, 1) == 0)
+            return false;
+        buffer[t & mask] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    // 只能由消费者线程调用；队列空返回 false
+    bool try_pop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if(ready_slots(h, 1) == 0)
+            return false;
+        value = buffer[h & mask];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    /*
+    * @brief 批量入队：尽量写入 values[0, n)，只发布一次 tail
+    * @return 实际写入的个数（队列剩余空间不足时小于 n）
+    */
+    size_t push_bulk(const T* values, size_t n) {
+        size_t t = tail.load(memory_order_relaxed);
+        n = min(n, free_slots(t, n));
+        for(size_t i = 0; i < n; i++)
+            buffer[(t + i) & mask] = values[i];
+        if(n)
+            tail.store(t + n, memory_order_release);
+        return n;
+    }
+
+    /*
+    * @brief 批量出队：最多读出 max_n 个元素到 out，只发布一次 head
+    * @return 实际读出的个数
+    */
+    size_t pop_bulk(T* out, size_t max_n) {
+        size_t h = head.load(memory_order_relaxed);
+        size_t n = min(max_n, ready_slots(h, max_n));
+        for(size_t i = 0; i < n; i++)
+            out[i] = buffer[(h + i) & mask];
+        if(n)
+            head.store(h + n, memory_order_release);
+        return n;
+    }
+
+    // 近似大小：并发修改时只是某一时刻的快照
+    size_t size() const {
+        return tail.load(memory_order_acquire) - head.load(memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+// 把当前线程绑定到指定 CPU（仅 Linux），返回是否成功
+bool pin_to_cpu(unsigned cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % max(thread::hardware_concurrency(), 1u), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// 在作用域内把当前线程绑定到指定 CPU，离开作用域时恢复原来的亲和性，不影响之后在同一线程上运行的代码
+class scoped_cpu_pin
+{
+#ifdef __linux__
+    cpu_set_t saved;
+    bool restore = false;
+#endif
+
+public:
+    explicit scoped_cpu_pin(unsigned cpu) {
+#ifdef __linux__
+        restore = pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0 && pin_to_cpu(cpu);
+#else
+        (void)cpu;
+#endif
+    }
+
+    ~scoped_cpu_pin() {
+#ifdef __linux__
+        if(restore)
+            pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+#endif
+    }
+
+    scoped_cpu_pin(const scoped_cpu_pin&) = delete;
+    scoped_cpu_pin& operator=(const scoped_cpu_pin&) = delete;
+};
+
+void test_spsc_basic() {
+    spsc_queue<int> q(4);
+    int value;
+    assert(!q.try_pop(value));
+    for(int i = 0; i < 4; i++)
+        assert(q.try_push(i));
+    assert(!q.try_push(4)); // 满
+    assert(q.size() == 4);
+    for(int i = 0; i < 4; i++) {
+        assert(q.try_pop(value));
+        assert(value == i);
+    }
+    assert(!q.try_pop(value));
+
+    int in[6] = {10, 11, 12, 13, 14, 15}, out[6];
+    assert(q.push_bulk(in, 6) == 4); // 只放得下 4 个
+    assert(q.pop_bulk(out, 3) == 3);
+    assert(out[0] == 10 && out[2] == 12);
+    assert(q.push_bulk(in + 4, 2) == 2); // 跨越环形缓冲区末尾
+    assert(q.pop_bulk(out, 6) == 3);
+    assert(out[0] == 13 && out[1] == 14 && out[2] == 15);
+    cout << "SPSC basic test passed.\n";
+}
+
+// 两个线程之间传递 0..n-1，消费者检查顺序
+void test_spsc_concurrent() {
+    const uint64_t kItems = 1000000;
+    spsc_queue<uint64_t> q(256);
+    thread producer([&]{
+        uint64_t batch[32];
+        uint64_t next = 0;
+        while(next < kItems) {
+            if(next % 3 == 0) { // 单个与批量交替使用
+                if(q.try_push(next)) next++;
+                else this_thread::yield();
+                continue;
+            }
+            size_t n = static_cast<size_t>(min<uint64_t>(32, kItems - next));
+            for(size_t i = 0; i < n; i++) batch[i] = next + i;
+            size_t pushed = q.push_bulk(batch, n);
+            if(pushed == 0) this_thread::yield();
+            next += pushed;
+        }
+    });
+    uint64_t expect = 0, out[64];
+    while(expect < kItems) {
+        size_t n = q.pop_bulk(out, 64);
+        if(n == 0) this_thread::yield();
+        for(size_t i = 0; i < n; i++)
+            assert(out[i] == expect++);
+    }
+    producer.join();
+    assert(q.size() == 0);
+    cout << "SPSC concurrent test passed.\n";
+}
+
+// 与 producer_consumer.cpp 相同的做法：互斥锁 + 条件变量，每个元素一次唤醒
+template<typename T>
+class mutex_cv_queue
+{
+    queue<T> data_queue;
+    mutex queue_mutex;
+    condition_variable data_cond;
+    size_t max_size;
+
+public:
+    explicit mutex_cv_queue(size_t capacity) : max_size(capacity) {}
+
+    void push(T value) {
+        unique_lock<mutex> lock(queue_mutex);
+        data_cond.wait(lock, [this]{ return data_queue.size() < max_size; });
+        data_queue.push(move(value));
+        lock.unlock();
+        data_cond.notify_all();
+    }
+
+    void pop(T& value) {
+        unique_lock<mutex> lock(queue_mutex);
+        data_cond.wait(lock, [this]{ return !data_queue.empty(); });
+        value = move(data_queue.front());
+        data_queue.pop();
+        lock.unlock();
+        data_cond.notify_all();
+    }
+};
+
+template<typename F>
+double time_s(F&& f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/*
+    吞吐量基准：生产者、消费者分别绑定到 CPU 0 和 CPU 1，传递 n 个 uint64_t，单位 M items/s。
+    batch = 1 时使用 try_push/try_pop，否则使用 push_bulk/pop_bulk。
+*/
+double spsc_throughput(uint64_t n, size_t batch)
+{
+    spsc_queue<uint64_t> q(4096);
+    vector<uint64_t> in(batch), out(batch);
+    uint64_t sum = 0;
+    double s = time_s([&]{
+        thread producer([&]{
+            pin_to_cpu(1);
+            uint64_t next = 0;
+            while(next < n) {
+                if(batch == 1) {
+                    if(q.try_push(next)) next++;
+                    else this_thread::yield();
+                } else {
+                    size_t k = static_cast<size_t>(min<uint64_t>(batch, n - next));
+                    for(size_t i = 0; i < k; i++) in[i] = next + i;
+                    size_t pushed = q.push_bulk(in.data(), k);
+                    if(pushed == 0) this_thread::yield();
+                    next += pushed;
+                }
+            }
+        });
+        scoped_cpu_pin pin(0); // 主线程，结束时恢复
+        uint64_t received = 0, value;
+        while(received < n) {
+            if(batch == 1) {
+                if(q.try_pop(value)) { sum += value; received++; }
+                else this_thread::yield();
+            } else {
+                size_t k = q.pop_bulk(out.data(), batch);
+                if(k == 0) this_thread::yield();
+                for(size_t i = 0; i < k; i++) sum += out[i];
+                received += k;
+            }
+        }
+        producer.join();
+    });
+    assert(sum == n * (n - 1) / 2);
+    return n / s / 1e6;
+}
+
+double mutex_cv_throughput(uint64_t n)
+{
+    mutex_cv_queue<uint64_t> q(4096);
+    double s = time_s([&]{
+        thread producer([&]{
+            pin_to_cpu(1);
+            for(uint64_t i = 0; i < n; i++) q.push(i);
+        });
+        scoped_cpu_pin pin(0); // 主线程，结束时恢复
+        uint64_t value;
+        for(uint64_t i = 0; i < n; i++) q.pop(value);
+        producer.join();
+    });
+    return n / s / 1e6;
+}
+
+/*
+    延迟直方图：生产者把发送时刻（steady_clock 纳秒）放入队列，消费者收到后计算差值，
+    按 2 的幂分桶统计，并输出 p50/p99/p99.9。生产者每发送一个元素等待一小段时间，测的是空队列时的传递延迟。
+*/
+void bench_spsc_latency(uint64_t n = 1000000)
+{
+    auto now_ns = []{
+        return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count());
+    };
+    spsc_queue<uint64_t> q(1024);
+    vector<uint64_t> latencies;
+    latencies.reserve(n);
+
+    thread producer([&]{
+        pin_to_cpu(1);
+        for(uint64_t i = 0; i < n; i++) {
+            while(!q.try_push(now_ns())) this_thread::yield();
+            uint64_t until = now_ns() + 200;
+            while(now_ns() < until) {} // 控制发送速率
+        }
+    });
+    scoped_cpu_pin pin(0); // 主线程，结束时恢复
+    uint64_t sent_at;
+    for(uint64_t i = 0; i < n; i++) {
+        while(!q.try_pop(sent_at)) this_thread::yield();
+        latencies.push_back(now_ns() - sent_at);
+    }
+    producer.join();
+
+    uint64_t buckets[64] = {};
+    for(uint64_t l : latencies)
+        buckets[l ? 63 - __builtin_clzll(l) : 0]++;
+    cout << "latency histogram (ns):\n";
+    for(int b = 0; b < 64; b++)
+        if(buckets[b])
+            cout << "  [" << (1ull << b) << ", " << (2ull << b) << "): " << buckets[b] << "\n";
+
+    sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p){ return latencies[min<size_t>(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))]; };
+    cout << "p50 = " << pct(0.50) << " ns  p99 = " << pct(0.99) << " ns  p99.9 = " << pct(0.999) << " ns\n";
+}
+
+void bench_spsc_queue()
+{
+    const uint64_t kItems = 100000000;
+    cout << "cpus = " << thread::hardware_concurrency() << ", items = " << kItems << endl;
+    cout << "mutex+cv:        " << mutex_cv_throughput(kItems / 100) << " M items/s\n";
+    cout << "spsc try_push:   " << spsc_throughput(kItems, 1) << " M items/s\n";
+    for(size_t batch : {16, 64, 256})
+        cout << "spsc batch " << batch << ":  " << spsc_throughput(kItems, batch) << " M items/s\n";
+    bench_spsc_latency();
+}
+
+int main()
+{
+    test_spsc_basic();
+    test_spsc_concurrent();
+    // bench_spsc_queue();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <cassert>
+using namespace std;
+
+// g++ .\br_lock.cpp -std=c++17 -O2 -pthread
+
+/*
+    big-reader lock（分片读写锁）：
+        shared_mutex 的读者计数只有一个，所有读线程加锁/解锁都写同一个缓存行；
+        br_shared_mutex 把读者计数拆成 SLOTS 个，每个独占一个缓存行，线程固定使用其中一个，
+        读者只修改自己的槽，读锁开销与读线程数无关；写者则要检查全部槽，写锁代价是 O(SLOTS)，适合读远多于写的场景。
+    加锁协议（Dekker 式，全部使用 seq_cst）：
+        读者：自己的槽加一 -> 检查 writer 标志，若有写者则把槽减回去，等写者结束后重试；
+        写者：writer_mutex 串行化写者 -> 置 writer 标志 -> 等待所有槽归零。
+        读者和写者各自“先写后读”，两者至少有一方能看到对方，不会同时进入。
+    防止写者饥饿：写者一旦置上 writer 标志，新来的读者就不再进入，只需等已经在读的读者离开。
+    满足标准库 SharedMutex 要求（lock/try_lock/unlock/lock_shared/try_lock_shared/unlock_shared），
+    可以直接用于 std::unique_lock、std::shared_lock、std::lock_guard。
+*/
+class br_shared_mutex
+{
+private:
+    static constexpr size_t SLOTS = 64;
+
+    struct alignas(64) reader_slot {
+        atomic<int> readers{0};
+    };
+
+    reader_slot slots[SLOTS];
+    alignas(64) atomic<bool> writer{false}; // 有写者持有锁或正在等待
+    mutex writer_mutex;
+
+    // 线程首次使用时按轮转分配一个槽编号，之后固定不变（加锁和解锁必须用同一个槽）
+    static size_t my_slot() {
+        static atomic<size_t> next{0};
+        thread_local size_t slot = next.fetch_add(1, memory_order_relaxed) % SLOTS;
+        return slot;
+    }
+
+    bool no_readers() const {
+        for(auto& s : slots)
+            if(s.readers.load() != 0)
+                return false;
+        return true;
+    }
+
+public:
+    br_shared_mutex() = default;
+    br_shared_mutex(const br_shared_mutex&) = delete;
+    br_shared_mutex& operator=(const br_shared_mutex&) = delete;
+
+    void lock() {
+        writer_mutex.lock();
+        writer.store(true);
+        // 逐个等待每个槽归零：已置 writer 标志，归零的槽不会再增加
+        for(auto& s : slots)
+            while(s.readers.load() != 0)
+                this_thread::yield();
+    }
+
+    bool try_lock() {
+        if(!writer_mutex.try_lock())
+            return false;
+        writer.store(true);
+        if(no_readers())
+            return true;
+        writer.store(false);
+        writer_mutex.unlock();
+        return false;
+    }
+
+    void unlock() {
+        writer.store(false);
+        writer_mutex.unlock();
+    }
+
+    void lock_shared() {
+        atomic<int>& readers = slots[my_slot()].readers;
+        while(true) {
+            readers.fetch_add(1);
+            if(!writer.load())
+                return;
+            readers.fetch_sub(1); // 有写者：退出，让写者先进入
+            while(writer.load(memory_order_relaxed))
+                this_thread::yield();
+        }
+    }
+
+    bool try_lock_shared() {
+        atomic<int>& readers = slots[my_slot()].readers;
+        readers.fetch_add(1);
+        if(!writer.load())
+            return true;
+        readers.fetch_sub(1);
+        return false;
+    }
+
+    void unlock_shared() {
+        slots[my_slot()].readers.fetch_sub(1, memory_order_release);
+    }
+};
+
+// 与 share_mutex.cpp 相同的读写例子，只替换锁的类型
+vector<int> shared_values = {1, 2, 3};
+br_shared_mutex rwMutex;
+mutex print;
+
+void reader(int id) {
+    shared_lock lock(rwMutex); // 共享锁（多读）
+    lock_guard<mutex> lock_print(print);
+    cout << "Reader " << id << " sees: ";
+    for(int n : shared_values) cout << n << " ";
+    cout << "\n";
+}
+
+void writer() {
+    unique_lock lock(rwMutex); // 独占锁（单写）
+    shared_values.push_back(shared_values.back() + 1);
+}
+
+void demo_share_mutex() {
+    thread readers[4];
+    for(int i = 0; i < 4; ++i)
+        readers[i] = thread(reader, i);
+    thread writer_thread(writer);
+    for(auto& t : readers) t.join();
+    writer_thread.join();
+}
+
+void test_try_lock() {
+    br_shared_mutex m;
+    {
+        shared_lock<br_shared_mutex> r1(m);
+        assert(!m.try_lock()); // 有读者时写锁失败
+        thread other([&]{
+            assert(m.try_lock_shared()); // 读锁可以共享
+            m.unlock_shared();
+        });
+        other.join();
+    }
+    {
+        unique_lock<br_shared_mutex> w(m, try_to_lock);
+        assert(w.owns_lock());
+        thread other([&]{
+            assert(!m.try_lock_shared()); // 有写者时读锁失败
+            assert(!m.try_lock());
+        });
+        other.join();
+    }
+    cout << "Try lock test passed.\n";
+}
+
+/*
+    互斥性测试：写者把数组的所有元素同时加一（中间状态各元素不相等），
+    读者检查看到的所有元素都相等；另外用计数器确认写者之间、读写之间没有重叠。
+*/
+void test_mutual_exclusion() {
+    br_shared_mutex m;
+    vector<int> values(8, 0);
+    atomic<int> active_writers(0), active_readers(0);
+    vector<thread> threads;
+    for(int t = 0; t < 6; t++)
+        threads.emplace_back([&]{
+            for(int i = 0; i < 20000; i++) {
+                shared_lock<br_shared_mutex> lock(m);
+                active_readers++;
+                assert(active_writers == 0);
+                for(int v : values) assert(v == values[0]);
+                active_readers--;
+            }
+        });
+    for(int t = 0; t < 2; t++)
+        threads.emplace_back([&]{
+            for(int i = 0; i < 2000; i++) {
+                lock_guard<br_shared_mutex> lock(m);
+                assert(++active_writers == 1);
+                assert(active_readers == 0);
+                for(int& v : values) v++;
+                active_writers--;
+            }
+        });
+    for(auto& t : threads) t.join();
+    assert(values[0] == 4000);
+    cout << "Mutual exclusion test passed.\n";
+}
+
+// 写者饥饿测试：读者持续不断地加读锁，写者仍能在有限时间内拿到锁
+void test_writer_not_starved() {
+    br_shared_mutex m;
+    atomic<bool> done(false);
+    vector<thread> readers;
+    for(int t = 0; t < 4; t++)
+        readers.emplace_back([&]{
+            while(!done) {
+                shared_lock<br_shared_mutex> lock(m);
+                this_thread::sleep_for(chrono::microseconds(50)); // 读临界区较长，读者之间相互重叠
+            }
+        });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < 10; i++) {
+        lock_guard<br_shared_mutex> lock(m);
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    done = true;
+    for(auto& t : readers) t.join();
+    assert(ms < 1000);
+    cout << "Writer starvation test passed (10 writes in " << ms << " ms).\n";
+}
+
+/*
+    基准矩阵：线程数 x 写比例，每次操作读（或写）一个 16 个元素的数组，单位 Mops/s。
+*/
+template<typename SharedMutex>
+double rw_throughput(int threads, int write_per_mille, int ops_per_thread)
+{
+    SharedMutex m;
+    vector<int> values(16, 1);
+    atomic<bool> go(false);
+    atomic<long> sink(0); // 读出的结果汇总到这里，防止读操作被优化掉
+    vector<thread> workers;
+    for(int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]{
+            mt19937 rng(t);
+            long sum = 0;
+            while(!go) this_thread::yield();
+            for(int i = 0; i < ops_per_thread; i++) {
+                if(static_cast<int>(rng() % 1000) < write_per_mille) {
+                    unique_lock<SharedMutex> lock(m);
+                    values[i % 16]++;
+                } else {
+                    shared_lock<SharedMutex> lock(m);
+                    sum += accumulate(values.begin(), values.end(), 0L);
+                }
+            }
+            sink += sum;
+        });
+    auto start = chrono::steady_clock::now();
+    go = true;
+    for(auto& w : workers) w.join();
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return static_cast<double>(threads) * ops_per_thread / s / 1e6;
+}
+
+void bench_br_lock()
+{
+    const int kOpsPerThread = 200000;
+    cout << "cpus = " << thread::hardware_concurrency() << endl;
+    for(int write_per_mille : {0, 1, 10, 100, 500}) {
+        cout << "---- writes = " << write_per_mille / 10.0 << "% ----\n";
+        for(int threads = 1; threads <= 32; threads *= 2)
+            cout << "threads = " << threads
+                 << "  shared_mutex: " << rw_throughput<shared_mutex>(threads, write_per_mille, kOpsPerThread) << " Mops/s"
+                 << "  br_shared_mutex: " << rw_throughput<br_shared_mutex>(threads, write_per_mille, kOpsPerThread) << " Mops/s" << endl;
+    }
+}
+
+int main()
+{
+    demo_share_mutex();
+    test_try_lock();
+    test_mutual_exclusion();
+    test_writer_not_starved();
+    // bench_br_lock();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,363 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <tuple>
+#include <cstdint>
+#include <cassert>
+using namespace std;
+
+// g++ .\concurrent_hash_map.cpp -std=c++17 -O2 -pthread
+
+/*
+    并发哈希表（查找缓存），沿用 share_mutex.cpp 的读写锁思路，但做了锁分段（lock striping）：
+        按键的哈希值分到 N 个分片，每个分片有自己的 shared_mutex 和哈希表，
+        不同分片上的读写互不影响，一把全局锁的争用被分散到 N 把锁上；
+        扩容只发生在单个分片内部、只持有该分片的锁（unordered_map 自动 rehash），不会让整个表停下来；
+        可选容量上限：超出时用 CLOCK 算法淘汰。
+    CLOCK（近似 LRU）：
+        每个分片的键按插入顺序排成一个环，每个条目有一个“最近访问”位，查找命中时置位；
+        需要淘汰时指针在环上转动：遇到置位的条目清零并跳过（给第二次机会），遇到未置位的条目就淘汰它。
+        与 LRU 不同，命中时不需要移动链表节点，只写一个原子标志位，可以在共享锁（读锁）下完成。
+*/
+template<typename K, typename V, typename Hash = hash<K>>
+class concurrent_hash_map
+{
+private:
+    // unordered_map 的节点分配后地址不变，条目中可以直接放原子变量
+    struct entry {
+        V value;
+        mutable atomic<bool> referenced{false}; // CLOCK 访问位（const 的查找路径上也要置位）
+        size_t ring_pos = 0;                    // 在 CLOCK 环中的位置（仅限容量模式）
+        explicit entry(V v) : value(move(v)) {}
+    };
+
+    struct alignas(64) shard {
+        mutable shared_mutex mtx;
+        unordered_map<K, entry, Hash> map;
+        vector<K> ring;  // CLOCK 环，只在有容量上限时维护
+        size_t hand = 0; // CLOCK 指针
+        size_t evictions = 0;
+    };
+
+    vector<shard> shards;
+    const size_t shard_capacity; // 每个分片的容量上限，0 表示不限
+    const int shard_shift;
+
+    // 用哈希值的高位选分片，低位留给分片内的 unordered_map 选桶，两者互不相关
+    shard& shard_for(const K& key) {
+        uint64_t h = static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+        return shards[shard_shift == 64 ? 0 : static_cast<size_t>(h >> shard_shift)];
+    }
+    const shard& shard_for(const K& key) const {
+        return const_cast<concurrent_hash_map*>(this)->shard_for(key);
+    }
+
+    static int shift_for(size_t num_shards) {
+        int bits = 0;
+        while((size_t(1) << bits) < num_shards) bits++;
+        return 64 - bits;
+    }
+
+    // 从环中删除位置 i：把最后一个键移到 i，保持数组紧凑；调用前持有写锁
+    static void remove_from_ring(shard& s, size_t i) {
+        size_t last = s.ring.size() - 1;
+        if(i != last) {
+            s.ring[i] = move(s.ring[last]);
+            s.map.find(s.ring[i])->second.ring_pos = i;
+        }
+        s.ring.pop_back();
+        if(s.hand >= s.ring.size())
+            s.hand = 0;
+    }
+
+    // CLOCK 选出被淘汰的键在环中的位置；调用前持有写锁且环非空
+    static size_t clock_victim(shard& s) {
+        while(true) {
+            size_t i = s.hand;
+            s.hand = (s.hand + 1) % s.ring.size();
+            entry& e = s.map.find(s.ring[i])->second;
+            if(!e.referenced.exchange(false, memory_order_relaxed))
+                return i;
+        }
+    }
+
+public:
+    /*
+    * @param capacity：条目数上限（平均分到各分片），0 表示不限、不淘汰
+    *        num_shards：分片数，取整到 2 的幂；一般取线程数的数倍
+    */
+    explicit concurrent_hash_map(size_t capacity = 0, size_t num_shards = 64)
+        : shards(size_t(1) << (64 - shift_for(num_shards))),
+          shard_capacity(capacity == 0 ? 0 : max<size_t>(1, capacity / shards.size())),
+          shard_shift(shift_for(num_shards)) {}
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    // 查找：只加分片的读锁，命中时置 CLOCK 访问位（原子变量，读锁下也可以写）
+    bool find(const K& key, V& value) const {
+        const shard& s = shard_for(key);
+        shared_lock<shared_mutex> lock(s.mtx);
+        auto it = s.map.find(key);
+        if(it == s.map.end())
+            return false;
+        const entry& e = it->second;
+        if(shard_capacity != 0 && !e.referenced.load(memory_order_relaxed)) // 已置位时不再写，避免无谓地使缓存行失效
+            e.referenced.store(true, memory_order_relaxed);
+        value = e.value;
+        return true;
+    }
+
+    bool contains(const K& key) const {
+        const shard& s = shard_for(key);
+        shared_lock<shared_mutex> lock(s.mtx);
+        return s.map.count(key) != 0;
+    }
+
+    /*
+    * @brief 插入或更新；分片已满时先按 CLOCK 淘汰一个条目
+    * @return 新插入返回 true，更新已有键返回 false
+    */
+    bool insert_or_assign(K key, V value) {
+        shard& s = shard_for(key);
+        unique_lock<shared_mutex> lock(s.mtx);
+        auto it = s.map.find(key);
+        if(it != s.map.end()) {
+            it->second.value = move(value);
+            return false;
+        }
+        if(shard_capacity == 0) {
+            s.map.emplace(piecewise_construct, forward_as_tuple(move(key)), forward_as_tuple(move(value)));
+            return true;
+        }
+        size_t pos = s.ring.size();
+        if(s.ring.size() >= shard_capacity) {
+            pos = clock_victim(s); // 新键直接占用被淘汰的键在环中的位置
+            s.map.erase(s.ring[pos]);
+            s.ring[pos] = key;
+            s.evictions++;
+        } else {
+            s.ring.push_back(key);
+        }
+        s.map.emplace(piecewise_construct, forward_as_tuple(move(key)), forward_as_tuple(move(value))).first->second.ring_pos = pos;
+        return true;
+    }
+
+    bool erase(const K& key) {
+        shard& s = shard_for(key);
+        unique_lock<shared_mutex> lock(s.mtx);
+        auto it = s.map.find(key);
+        if(it == s.map.end())
+            return false;
+        size_t pos = it->second.ring_pos;
+        s.map.erase(it);
+        if(shard_capacity != 0)
+            remove_from_ring(s, pos);
+        return true;
+    }
+
+    // 逐个分片加读锁求和，并发修改时只是近似值
+    size_t size() const {
+        size_t n = 0;
+        for(auto& s : shards) {
+            shared_lock<shared_mutex> lock(s.mtx);
+            n += s.map.size();
+        }
+        return n;
+    }
+
+    size_t evictions() const {
+        size_t n = 0;
+        for(auto& s : shards) {
+            shared_lock<shared_mutex> lock(s.mtx);
+            n += s.evictions;
+        }
+        return n;
+    }
+
+    size_t shard_count() const { return shards.size(); }
+};
+
+// share_mutex.cpp 的做法：一把全局 shared_mutex 保护整个 unordered_map，作为基准对照
+template<typename K, typename V>
+class global_lock_map
+{
+    mutable shared_mutex mtx;
+    unordered_map<K, V> map;
+
+public:
+    bool find(const K& key, V& value) const {
+        shared_lock<shared_mutex> lock(mtx);
+        auto it = map.find(key);
+        if(it == map.end()) return false;
+        value = it->second;
+        return true;
+    }
+
+    bool insert_or_assign(K key, V value) {
+        unique_lock<shared_mutex> lock(mtx);
+        return map.insert_or_assign(move(key), move(value)).second;
+    }
+};
+
+void test_basic_operations() {
+    concurrent_hash_map<string, int> map(0, 8);
+    assert(map.shard_count() == 8);
+    int value;
+    assert(!map.find("a", value));
+    assert(map.insert_or_assign("a", 1));
+    assert(map.insert_or_assign("b", 2));
+    assert(!map.insert_or_assign("a", 10)); // 更新
+    assert(map.find("a", value) && value == 10);
+    assert(map.size() == 2);
+    assert(map.erase("a"));
+    assert(!map.erase("a"));
+    assert(!map.find("a", value));
+    assert(map.find("b", value) && value == 2);
+
+    // 不限容量时可以插入任意多个（各分片自行扩容）
+    for(int i = 0; i < 10000; i++)
+        map.insert_or_assign(to_string(i), i);
+    for(int i = 0; i < 10000; i += 7)
+        assert(map.find(to_string(i), value) && value == i);
+    assert(map.size() == 10001);
+    assert(map.evictions() == 0);
+    cout << "Basic operations test passed.\n";
+}
+
+// CLOCK：最近访问过的条目获得第二次机会
+void test_clock_eviction() {
+    concurrent_hash_map<int, int> cache(4, 1); // 单分片，容量 4
+    for(int i = 0; i < 4; i++)
+        cache.insert_or_assign(i, i);
+    int value;
+    assert(cache.find(0, value) && cache.find(2, value)); // 访问 0 和 2
+    cache.insert_or_assign(4, 4); // 淘汰 1（0 有访问位，跳过）
+    assert(!cache.find(1, value));
+    cache.insert_or_assign(5, 5); // 淘汰 3（2 有访问位，跳过）
+    assert(!cache.find(3, value));
+    assert(cache.find(0, value) && cache.find(2, value) && cache.find(4, value) && cache.find(5, value));
+    assert(cache.size() == 4 && cache.evictions() == 2);
+
+    // 多分片时总条目数不超过容量
+    concurrent_hash_map<int, int> bounded(1000, 16);
+    for(int i = 0; i < 100000; i++)
+        bounded.insert_or_assign(i, i);
+    assert(bounded.size() <= 1000);
+    assert(bounded.evictions() == 100000 - bounded.size());
+    cout << "CLOCK eviction test passed.\n";
+}
+
+// 并发读写：每个线程写自己的键段并读回，最后检查所有键都在
+void test_concurrent_access() {
+    concurrent_hash_map<int, int> map(0, 16);
+    const int kThreads = 8, kKeys = 20000;
+    vector<thread> threads;
+    for(int t = 0; t < kThreads; t++)
+        threads.emplace_back([&, t]{
+            int value;
+            for(int i = 0; i < kKeys; i++) {
+                int key = t * kKeys + i;
+                map.insert_or_assign(key, key * 2);
+                assert(map.find(key, value) && value == key * 2);
+                if(i % 4 == 0) assert(map.erase(key));
+                map.find((key * 31) % (kThreads * kKeys), value); // 读其他线程的键
+            }
+        });
+    for(auto& t : threads) t.join();
+    assert(map.size() == static_cast<size_t>(kThreads * kKeys * 3 / 4));
+    int value;
+    for(int key = 0; key < kThreads * kKeys; key++)
+        assert(map.find(key, value) == (key % kKeys % 4 != 0));
+    cout << "Concurrent access test passed.\n";
+}
+
+// std::hash<int> 是恒等映射，连续整数键会在 unordered_map 中顺序排列、局部性好得不真实；打散成伪随机键（双射）
+int scatter_key(int k)
+{
+    return static_cast<int>(static_cast<uint32_t>(k) * 2654435761u);
+}
+
+/*
+    基准：键空间 1M（预先填满），每个线程按给定读比例随机查找/写入，单位 Mops/s。
+    对比一把全局 shared_mutex 的 unordered_map 与 64 分片的 concurrent_hash_map。
+*/
+template<typename Map>
+double map_throughput(Map& map, int threads, int read_percent, int ops_per_thread, int key_space)
+{
+    atomic<bool> go(false);
+    atomic<long> sink(0);
+    vector<thread> workers;
+    for(int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]{
+            mt19937 rng(t);
+            long hits = 0;
+            int value;
+            while(!go) this_thread::yield();
+            for(int i = 0; i < ops_per_thread; i++) {
+                int key = scatter_key(static_cast<int>(rng() % key_space));
+                if(static_cast<int>(rng() % 100) < read_percent)
+                    hits += map.find(key, value);
+                else
+                    map.insert_or_assign(key, i);
+            }
+            sink += hits;
+        });
+    auto start = chrono::steady_clock::now();
+    go = true;
+    for(auto& w : workers) w.join();
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return static_cast<double>(threads) * ops_per_thread / s / 1e6;
+}
+
+void bench_concurrent_hash_map()
+{
+    const int kKeys = 1 << 20, kOpsPerThread = 500000;
+    cout << "cpus = " << thread::hardware_concurrency() << endl;
+    for(int read_percent : {95, 50}) {
+        cout << "---- " << read_percent << "/" << 100 - read_percent << " read/write ----\n";
+        for(int threads = 1; threads <= 16; threads *= 2) {
+            global_lock_map<int, int> global;
+            concurrent_hash_map<int, int> striped(0, 64);
+            for(int k = 0; k < kKeys; k++) {
+                global.insert_or_assign(scatter_key(k), k);
+                striped.insert_or_assign(scatter_key(k), k);
+            }
+            cout << "threads = " << threads
+                 << "  global shared_mutex: " << map_throughput(global, threads, read_percent, kOpsPerThread, kKeys) << " Mops/s"
+                 << "  striped: " << map_throughput(striped, threads, read_percent, kOpsPerThread, kKeys) << " Mops/s" << endl;
+        }
+    }
+
+    // 缓存命中率：容量为键空间的 1/8，访问分布倾斜（小键更热），未命中时写入
+    concurrent_hash_map<int, int> cache(kKeys / 8, 64);
+    mt19937 rng(1);
+    long hits = 0, total = 4000000;
+    int value;
+    for(long i = 0; i < total; i++) {
+        double u = (rng() % 1000000) / 1000000.0;
+        int key = static_cast<int>(u * u * u * kKeys);
+        if(cache.find(key, value)) hits++;
+        else cache.insert_or_assign(key, key);
+    }
+    cout << "CLOCK cache (capacity " << kKeys / 8 << "): hit rate " << 100.0 * hits / total << "%"
+         << ", evictions " << cache.evictions() << endl;
+}
+
+int main()
+{
+    test_basic_operations();
+    test_clock_eviction();
+    test_concurrent_access();
+    // bench_concurrent_hash_map();
+
+    return 0;
+}
\ No newline at end of file
@@ -1,6 +1,17 @@
 #include <iostream>
 #include <mutex>
 #include <thread>
+#include <vector>
+#include <array>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <cassert>
 using namespace std;
 
 std::mutex t_lock1;
@@ -87,9 +98,257 @@ void test_safe_lock() {
     t2.join();
 }
 
+/*
+    上面的做法要求任何时候最多持有一把锁，但有时必须同时修改由多把锁保护的数据（比如 m_1 和 m_2 要一起变），
+    分开加锁时别的线程可能看到只改了一半的状态。同时持有多把锁又不死锁有两种办法：
+    1. 按地址排序：所有线程都按锁的地址从小到大加锁，全局顺序一致，不可能形成环；
+    2. 尝试并回退（std::lock 的做法）：阻塞地锁住一把，其余用 try_lock，任何一把失败就全部释放，
+       随机让出 CPU 一段时间后从失败的那把锁开始重试，不持有锁等待，因此也不会死锁。
+    std::scoped_lock 要求锁的个数在编译期确定，multi_lock_guard 接受运行时数量的锁（同一把锁出现多次只加一次）。
+*/
+enum class multi_lock_policy { address_order, try_and_back_off };
+
+// 两种加锁方式中途 lock()/try_lock() 抛异常时，都先释放已拿到的锁再重新抛出
+template<typename Mutex>
+void lock_in_address_order(Mutex* const* locks, size_t n)
+{
+    size_t i = 0;
+    try {
+        for(; i < n; i++) // 调用者已按地址排好序
+            locks[i]->lock();
+    } catch(...) {
+        while(i > 0)
+            locks[--i]->unlock();
+        throw;
+    }
+}
+
+template<typename Mutex>
+void lock_with_back_off(Mutex* const* locks, size_t n)
+{
+    if(n == 0)
+        return;
+    thread_local mt19937 rng(random_device{}());
+    size_t first = 0;
+    int failures = 0;
+    while(true) {
+        locks[first]->lock();
+        size_t failed = n, k = 1;
+        try {
+            for(; k < n; k++) {
+                size_t i = (first + k) % n;
+                if(!locks[i]->try_lock()) {
+                    failed = i;
+                    break;
+                }
+            }
+        } catch(...) {
+            for(size_t j = 0; j < k; j++)
+                locks[(first + j) % n]->unlock();
+            throw;
+        }
+        if(failed == n)
+            return;
+        for(size_t i = first; i != failed; i = (i + 1) % n)
+            locks[i]->unlock();
+        // 下一轮先阻塞在刚才失败的锁上；随机让出若干次，失败越多让得越久，避免几个线程步调一致地反复冲突
+        first = failed;
+        failures = min(failures + 1, 6);
+        for(unsigned y = rng() % (1u << failures); y > 0; y--)
+            this_thread::yield();
+    }
+}
+
+// 锁的数量不超过 INLINE_LOCKS 时不分配内存
+template<typename Mutex>
+class multi_lock_guard
+{
+    static constexpr size_t INLINE_LOCKS = 8;
+    Mutex* inline_locks[INLINE_LOCKS];
+    vector<Mutex*> overflow;
+    Mutex** locks;
+    size_t n;
+
+public:
+    // 需要先求个数再拷贝，范围要遍历两次，所以要求前向迭代器
+    template<typename ForwardIt>
+    multi_lock_guard(ForwardIt first, ForwardIt last, multi_lock_policy policy = multi_lock_policy::address_order) {
+        size_t count = static_cast<size_t>(distance(first, last));
+        if(count <= INLINE_LOCKS) {
+            locks = inline_locks;
+        } else {
+            overflow.resize(count);
+            locks = overflow.data();
+        }
+        copy(first, last, locks);
+        sort(locks, locks + count, less<Mutex*>()); // std::less 对任意指针都给出全序
+        n = static_cast<size_t>(unique(locks, locks + count) - locks);
+        if(policy == multi_lock_policy::address_order)
+            lock_in_address_order(locks, n);
+        else
+            lock_with_back_off(locks, n);
+    }
+
+    multi_lock_guard(initializer_list<Mutex*> ms, multi_lock_policy policy = multi_lock_policy::address_order)
+        : multi_lock_guard(ms.begin(), ms.end(), policy) {}
+
+    ~multi_lock_guard() {
+        for(size_t i = n; i > 0; i--)
+            locks[i - 1]->unlock();
+    }
+
+    multi_lock_guard(const multi_lock_guard&) = delete;
+    multi_lock_guard& operator=(const multi_lock_guard&) = delete;
+};
+
+// 加锁时可以让它抛异常的锁，用于检查 multi_lock_guard 中途失败时会释放已拿到的锁
+struct throwing_mutex {
+    std::mutex m;
+    bool fail = false;
+    void lock() { if(fail) throw runtime_error("lock failed"); m.lock(); }
+    bool try_lock() { if(fail) throw runtime_error("lock failed"); return m.try_lock(); }
+    void unlock() { m.unlock(); }
+};
+
+// 与 dead_lock1/dead_lock2 相同的相反加锁顺序，但 m_1 和 m_2 在同一个临界区内一起修改，不会死锁
+void test_multi_lock() {
+    for(auto policy : {multi_lock_policy::address_order, multi_lock_policy::try_and_back_off}) {
+        m_1 = 0;
+        m_2 = 0;
+        auto worker = [policy](std::mutex* first, std::mutex* second) {
+            for(int i = 0; i < 20000; i++) {
+                multi_lock_guard<std::mutex> lock({first, second}, policy);
+                assert(m_1 == m_2); // 不会看到只改了一半的状态
+                m_1++;
+                m_2++;
+            }
+        };
+        thread t1(worker, &t_lock1, &t_lock2);
+        thread t2(worker, &t_lock2, &t_lock1);
+        t1.join();
+        t2.join();
+        assert(m_1 == 40000 && m_2 == 40000);
+    }
+    {
+        multi_lock_guard<std::mutex> lock({&t_lock1, &t_lock2, &t_lock1}); // 重复的锁只加一次
+    }
+    {
+        vector<std::mutex> many(20);
+        vector<std::mutex*> ptrs;
+        for(auto& m : many) ptrs.push_back(&m);
+        multi_lock_guard<std::mutex> lock(ptrs.rbegin(), ptrs.rend(), multi_lock_policy::try_and_back_off);
+        thread other([&]{ // 对自己已持有的 std::mutex 调用 try_lock 是未定义行为
+            for(auto& m : many) {
+                bool held = !m.try_lock();
+                assert(held);
+                (void)held;
+            }
+        });
+        other.join();
+    }
+    for(auto policy : {multi_lock_policy::address_order, multi_lock_policy::try_and_back_off}) {
+        vector<throwing_mutex> ms(4);
+        vector<throwing_mutex*> ptrs;
+        for(auto& m : ms) ptrs.push_back(&m);
+        sort(ptrs.begin(), ptrs.end(), less<throwing_mutex*>());
+        ptrs.back()->fail = true; // 地址最大的锁最后加，失败时前面的锁都已拿到
+        bool thrown = false;
+        try {
+            multi_lock_guard<throwing_mutex> lock(ptrs.begin(), ptrs.end(), policy);
+        } catch(const runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        (void)thrown;
+        for(auto* m : ptrs) {
+            if(m->fail) continue;
+            bool released = m->m.try_lock();
+            assert(released);
+            if(released) m->m.unlock();
+        }
+    }
+    cout << "Multi lock test passed.\n";
+}
+
+/*
+    基准：kLocks 把锁各保护一个计数器，每次操作随机选 N 把不同的锁同时加锁并修改对应计数器，
+    锁少线程多，不同线程选中的锁集合大量交叉。比较 std::scoped_lock（libstdc++ 中即 std::lock 的尝试并回退）
+    与 multi_lock_guard 的两种策略，单位 Mops/s。
+*/
+struct alignas(64) guarded_counter {
+    std::mutex m;
+    long value = 0;
+};
+
+template<size_t N, typename LockFn>
+double multi_lock_throughput(int threads, int ops_per_thread, LockFn lock_fn)
+{
+    const int kLocks = 8;
+    vector<guarded_counter> counters(kLocks);
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for(int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]{
+            mt19937 rng(t);
+            array<int, kLocks> order;
+            for(int i = 0; i < kLocks; i++) order[i] = i;
+            for(int i = 0; i < ops_per_thread; i++) {
+                // 随机选 N 把不同的锁（部分洗牌），顺序也是随机的
+                for(size_t k = 0; k < N; k++)
+                    swap(order[k], order[k + rng() % (kLocks - k)]);
+                array<guarded_counter*, N> picked;
+                for(size_t k = 0; k < N; k++) picked[k] = &counters[order[k]];
+                lock_fn(picked);
+            }
+        });
+    for(auto& w : workers) w.join();
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long total = 0;
+    for(auto& c : counters) total += c.value;
+    assert(total == static_cast<long>(threads) * ops_per_thread * static_cast<long>(N));
+    (void)total;
+    return static_cast<double>(threads) * ops_per_thread / s / 1e6;
+}
+
+template<size_t N>
+void bench_multi_lock_n(int threads, int ops_per_thread)
+{
+    auto with_scoped_lock = [](auto& picked) {
+        apply([](auto*... c) {
+            scoped_lock lock(c->m...);
+            ((c->value++), ...);
+        }, picked);
+    };
+    auto with_policy = [](multi_lock_policy policy) {
+        return [policy](auto& picked) {
+            array<std::mutex*, N> ms;
+            for(size_t k = 0; k < N; k++) ms[k] = &picked[k]->m;
+            multi_lock_guard<std::mutex> lock(ms.begin(), ms.end(), policy);
+            for(auto* c : picked) c->value++;
+        };
+    };
+    cout << N << " locks, threads = " << threads
+         << "  scoped_lock: " << multi_lock_throughput<N>(threads, ops_per_thread, with_scoped_lock)
+         << "  address_order: " << multi_lock_throughput<N>(threads, ops_per_thread, with_policy(multi_lock_policy::address_order))
+         << "  try_and_back_off: " << multi_lock_throughput<N>(threads, ops_per_thread, with_policy(multi_lock_policy::try_and_back_off))
+         << " Mops/s" << endl;
+}
+
+void bench_multi_lock()
+{
+    const int kOpsPerThread = 200000;
+    cout << "cpus = " << thread::hardware_concurrency() << endl;
+    for(int threads = 1; threads <= 16; threads *= 2) {
+        bench_multi_lock_n<2>(threads, kOpsPerThread);
+        bench_multi_lock_n<4>(threads, kOpsPerThread);
+    }
+}
+
 int main()
 {
     // test_dead_lock();
+    test_multi_lock();
+    // bench_multi_lock();
     test_safe_lock();
     
     return 0;
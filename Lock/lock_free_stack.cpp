@@ -0,0 +1,384 @@
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stack>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <assert.h>
+using namespace std;
+
+// g++ .\lock_free_stack.cpp -std=c++17 -O2 -pthread
+
+/*
+    无锁栈（Treiber stack），接口与 threadSafe.cpp 中的 threadsafe_stack 相同：
+        push/pop 通过对栈顶指针做 CAS（compare_exchange）完成，不使用互斥锁；
+        ABA 问题：栈顶指针带16位版本号（tagged pointer），每次修改版本号加一，
+            即使同一地址的节点被释放后重新分配并压栈，CAS 也会因版本号不同而失败；
+        内存回收：弹出的节点可能正被其他线程读取（读 next），不能立即 delete。
+            使用风险指针（hazard pointer）：线程在解引用节点前先把地址登记到自己的风险指针槽，
+            回收时跳过所有被登记的节点，等以后再扫描。
+*/
+
+// ================= 风险指针 =================
+constexpr size_t MAX_HAZARD_POINTERS = 128; // 同时访问无锁栈的线程数上限
+
+struct alignas(64) hazard_slot {
+    atomic<bool> in_use{false};
+    atomic<void*> pointer{nullptr};
+};
+
+hazard_slot hazard_slots[MAX_HAZARD_POINTERS];
+
+// 每个线程首次使用时占用一个槽，线程退出时归还
+class hazard_owner
+{
+    hazard_slot* _slot = nullptr;
+public:
+    hazard_owner() {
+        for(auto& slot : hazard_slots) {
+            bool expected = false;
+            if(slot.in_use.compare_exchange_strong(expected, true)) {
+                _slot = &slot;
+                return;
+            }
+        }
+        throw runtime_error("No hazard pointers available");
+    }
+    ~hazard_owner() {
+        _slot->pointer.store(nullptr);
+        _slot->in_use.store(false);
+    }
+    atomic<void*>& pointer() { return _slot->pointer; }
+};
+
+atomic<void*>& my_hazard_pointer()
+{
+    thread_local hazard_owner owner;
+    return owner.pointer();
+}
+
+// 收集当前所有被登记的风险指针（排序后便于二分查找）
+vector<void*> collect_hazards()
+{
+    vector<void*> hazards;
+    hazards.reserve(MAX_HAZARD_POINTERS);
+    for(auto& slot : hazard_slots)
+        if(void* p = slot.pointer.load())
+            hazards.push_back(p);
+    sort(hazards.begin(), hazards.end());
+    return hazards;
+}
+
+// 待回收节点：类型擦除后统一保存，deleter 负责按原类型释放
+struct retired_node {
+    void* pointer;
+    void (*deleter)(void*);
+};
+
+// 退出线程遗留的待回收节点，由仍在运行的线程接管；程序结束时统一释放
+struct orphan_list {
+    mutex mtx;
+    vector<retired_node> nodes;
+    ~orphan_list() {
+        for(auto& n : nodes)
+            n.deleter(n.pointer);
+    }
+};
+
+orphan_list orphans;
+
+class retire_list
+{
+    vector<retired_node> _nodes;
+public:
+    // 待回收节点数超过风险指针总数的两倍时扫描一次，保证每次扫描至少能回收一半
+    void add(void* p, void (*deleter)(void*)) {
+        _nodes.push_back({p, deleter});
+        if(_nodes.size() >= 2 * MAX_HAZARD_POINTERS)
+            scan();
+    }
+
+    void scan() {
+        {
+            lock_guard<mutex> lock(orphans.mtx);
+            _nodes.insert(_nodes.end(), orphans.nodes.begin(), orphans.nodes.end());
+            orphans.nodes.clear();
+        }
+        // 每次扫描只读一遍风险指针表，而不是对每个节点都遍历一遍
+        vector<void*> hazards = collect_hazards();
+        auto keep = partition(_nodes.begin(), _nodes.end(), [&hazards](const retired_node& n){
+            return binary_search(hazards.begin(), hazards.end(), n.pointer);
+        });
+        for(auto it = keep; it != _nodes.end(); ++it)
+            it->deleter(it->pointer);
+        _nodes.erase(keep, _nodes.end());
+    }
+
+    ~retire_list() {
+        lock_guard<mutex> lock(orphans.mtx);
+        orphans.nodes.insert(orphans.nodes.end(), _nodes.begin(), _nodes.end());
+    }
+};
+
+template<typename Node>
+void retire(Node* p)
+{
+    thread_local retire_list retired;
+    retired.add(p, [](void* q){ delete static_cast<Node*>(q); });
+}
+
+// ================= 无锁栈 =================
+template<typename T>
+class lock_free_stack {
+private:
+    // 数据以 shared_ptr 保存，压栈时就分配好，弹栈取出节点后不再有可能抛异常的操作
+    struct node {
+        shared_ptr<T> data;
+        node* next = nullptr;
+        explicit node(T value) : data(make_shared<T>(move(value))) {}
+    };
+
+    /*
+        tagged pointer：x86-64/AArch64 用户态地址只用低48位，高16位存放版本号，
+        指针和版本号合在一个64位整数里，一次 CAS 就能同时比较两者。
+    */
+    static_assert(sizeof(void*) == 8, "tagged pointer requires 64-bit pointers");
+    static constexpr uint64_t PTR_MASK = (uint64_t(1) << 48) - 1;
+
+    static uint64_t pack(node* p, uint64_t tag) {
+        return (reinterpret_cast<uint64_t>(p) & PTR_MASK) | (tag << 48);
+    }
+    static node* ptr(uint64_t v) { return reinterpret_cast<node*>(v & PTR_MASK); }
+    static uint64_t tag(uint64_t v) { return v >> 48; }
+
+    atomic<uint64_t> head{0};
+    atomic<size_t> count{0}; // 近似大小：并发修改时只是某一时刻的快照
+
+    // 取下栈顶节点；栈空返回 nullptr
+    node* pop_node() {
+        atomic<void*>& hp = my_hazard_pointer();
+        uint64_t old_head = head.load();
+        node* p;
+        do {
+            // 登记风险指针后重新读栈顶，确认该节点在登记时仍未被弹出，之后它就不会被释放
+            uint64_t again;
+            do {
+                p = ptr(old_head);
+                hp.store(p);
+                again = head.load();
+            } while(again != old_head && ((old_head = again), true));
+
+            if(!p)
+                break;
+        } while(!head.compare_exchange_strong(old_head, pack(p->next, tag(old_head) + 1)));
+        hp.store(nullptr);
+        if(p)
+            count--;
+        return p;
+    }
+
+public:
+    lock_free_stack() = default;
+
+    // 拷贝需要遍历整个链表，在无锁结构上无法与并发修改安全地同时进行，因此禁用
+    lock_free_stack(const lock_free_stack&) = delete;
+    lock_free_stack& operator=(const lock_free_stack&) = delete;
+
+    ~lock_free_stack() {
+        node* p = ptr(head.load());
+        while(p) {
+            node* next = p->next;
+            delete p;
+            p = next;
+        }
+    }
+
+    // 压栈操作（无锁）：新节点的 next 指向当前栈顶，CAS 失败说明栈顶变了，old_head 已被更新为新栈顶，重试即可
+    void push(T new_value) {
+        node* n = new node(move(new_value));
+        count++; // 节点发布之前计数，并发的 pop_node 先减也不会使计数回绕
+        uint64_t old_head = head.load();
+        do {
+            n->next = ptr(old_head);
+        } while(!head.compare_exchange_weak(old_head, pack(n, tag(old_head) + 1)));
+    }
+
+    // 弹栈操作（返回智能指针）
+    shared_ptr<T> pop() {
+        node* p = pop_node();
+        if(!p) throw out_of_range("Stack is empty!");
+        shared_ptr<T> res = move(p->data); // 不分配内存，不会抛异常
+        retire(p); // 其他线程可能还持有该节点的风险指针，交给回收链表延后释放
+        return res;
+    }
+
+    // 弹栈操作（通过引用返回结果）
+    void pop(T& value) {
+        node* p = pop_node();
+        if(!p) throw out_of_range("Stack is empty!");
+        value = move(*p->data);
+        retire(p);
+    }
+
+    bool empty() const {
+        return ptr(head.load()) == nullptr;
+    }
+
+    size_t size() const {
+        return count.load();
+    }
+};
+
+// 与 threadSafe.cpp 中相同的互斥锁版本，用作基准对照
+template<typename T>
+class threadsafe_stack {
+private:
+    std::stack<T> data;
+    mutable std::mutex mtx;
+
+public:
+    void push(T new_value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        data.push(std::move(new_value));
+    }
+
+    std::shared_ptr<T> pop() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (data.empty()) throw std::out_of_range("Stack is empty!");
+        auto res = std::make_shared<T>(std::move(data.top()));
+        data.pop();
+        return res;
+    }
+
+    void pop(T& value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (data.empty()) throw std::out_of_range("Stack is empty!");
+        value = std::move(data.top());
+        data.pop();
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return data.empty();
+    }
+};
+
+// 基本功能测试（单线程）
+void test_basic_operations() {
+    lock_free_stack<int> stack;
+    stack.push(1);
+    stack.push(2);
+    assert(stack.size() == 2);
+
+    auto top1 = stack.pop();
+    assert(*top1 == 2);
+
+    int value;
+    stack.pop(value);
+    assert(value == 1);
+    assert(stack.empty());
+
+    bool thrown = false;
+    try {
+        stack.pop();
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::cout << "Basic operations test passed.\n";
+}
+
+/*
+    压力测试：生产者压入互不相同的值，消费者并发弹出，
+    每个值必须恰好被弹出一次（既不丢失也不重复），最后栈为空。
+*/
+void test_stress() {
+    lock_free_stack<int> stack;
+    const int kNumThreads = 8;
+    const int kPushesPerThread = 100000;
+    const int kTotal = kNumThreads * kPushesPerThread;
+    std::vector<std::atomic<int>> seen(kTotal);
+    std::atomic<int> pop_count(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < kNumThreads; ++i) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < kPushesPerThread; ++j)
+                stack.push(i * kPushesPerThread + j);
+        });
+        threads.emplace_back([&] {
+            int value;
+            while (pop_count < kTotal) {
+                try {
+                    stack.pop(value);
+                    seen[value]++;
+                    ++pop_count;
+                } catch (const std::out_of_range&) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    assert(stack.empty());
+    assert(pop_count == kTotal);
+    for (auto& s : seen)
+        assert(s == 1);
+    std::cout << "Stress test passed.\n";
+}
+
+/*
+    吞吐量基准：每个线程交替 push/pop，统计每秒完成的操作数（Mops/s）。
+    先预填一些元素，使 pop 基本不会遇到空栈。
+*/
+template<typename Stack>
+double stack_throughput(int num_threads, int ops_per_thread) {
+    Stack stack;
+    for (int i = 0; i < 1024; ++i) stack.push(i);
+
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&] {
+            while (!go) std::this_thread::yield();
+            int value;
+            for (int i = 0; i < ops_per_thread / 2; ++i) {
+                stack.push(i);
+                try {
+                    stack.pop(value);
+                } catch (const std::out_of_range&) {}
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& t : threads) t.join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(num_threads) * ops_per_thread / s / 1e6;
+}
+
+void bench_stack() {
+    const int kOpsPerThread = 200000;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        double mutex_mops = stack_throughput<threadsafe_stack<int>>(threads, kOpsPerThread);
+        double lock_free_mops = stack_throughput<lock_free_stack<int>>(threads, kOpsPerThread);
+        std::cout << "threads = " << threads
+                  << "  mutex: " << mutex_mops << " Mops/s"
+                  << "  lock-free: " << lock_free_mops << " Mops/s" << std::endl;
+    }
+}
+
+int main()
+{
+    test_basic_operations();
+    test_stress();
+    // bench_stack();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <chrono>
+#include <cassert>
+using namespace std;
+
+// g++ .\lock_order_checker.cpp -std=c++17 -O2 -pthread         （检查模式）
+// g++ .\lock_order_checker.cpp -std=c++17 -O2 -pthread -DNDEBUG （发布模式，检查代码全部编译掉）
+
+/*
+    deadlock.cpp 中 dead_lock1 按 t_lock1 -> t_lock2 的顺序加锁，dead_lock2 按 t_lock2 -> t_lock1 加锁，
+    两个线程各持有一把锁等对方，形成死锁。实际代码中经常必须同时持有多把锁，
+    只要所有线程都按同一个全局顺序加锁就不会死锁，问题是怎样发现违反顺序的代码。
+
+    运行时锁顺序检查（类似 Linux 内核的 lockdep）：
+        每个线程记录自己当前持有的锁（持锁栈）；
+        线程持有 A 时去加 B，就在全局的锁顺序图中记下一条边 A -> B，同时记下当时的持锁栈；
+        新增边 A -> B 之前先检查图中是否已有 B -> ... -> A 的路径，有则说明存在相反的加锁顺序，
+            即使这次没有真的死锁（两个线程没有恰好交错），也在加锁之前抛出 lock_order_error，
+            报告中包含本线程的持锁栈和之前记录相反顺序时的持锁栈。
+    只要测试中每条加锁路径都被执行过一次，就能发现潜在的死锁，不依赖线程调度的巧合。
+
+    通过模板策略参数选择是否检查：
+        lock_order_check：检查模式，默认用于未定义 NDEBUG 的调试构建；
+        no_lock_order_check：发布模式，ordered_mutex 只是对底层互斥锁的内联转发，大小和开销与原互斥锁相同。
+*/
+
+struct lock_order_check {};
+struct no_lock_order_check {};
+
+#ifdef NDEBUG
+using default_lock_order_policy = no_lock_order_check;
+#else
+using default_lock_order_policy = lock_order_check;
+#endif
+
+class lock_order_error : public logic_error
+{
+public:
+    explicit lock_order_error(const string& report) : logic_error(report) {}
+};
+
+// ================= 锁顺序图 =================
+struct held_lock {
+    uint64_t id;
+    const char* name;
+};
+
+thread_local vector<held_lock> held_locks; // 本线程当前持有的锁，按加锁顺序
+
+class lock_order_graph
+{
+    mutex mtx; // 保护图本身（普通互斥锁，不参与检查）
+    // edges[a][b]：存在 a -> b 的加锁顺序，值为第一次观察到这条边时的持锁栈描述
+    unordered_map<uint64_t, unordered_map<uint64_t, string>> edges;
+
+    // 深度优先搜索 from 到 to 的路径，找到时 path 为路径上的节点（含两端）
+    bool find_path(uint64_t from, uint64_t to, vector<uint64_t>& path, unordered_set<uint64_t>& visited) {
+        path.push_back(from);
+        if(from == to)
+            return true;
+        visited.insert(from);
+        auto it = edges.find(from);
+        if(it != edges.end())
+            for(auto& [next, stack] : it->second)
+                if(!visited.count(next) && find_path(next, to, path, visited))
+                    return true;
+        path.pop_back();
+        return false;
+    }
+
+    static string describe_stack(const vector<held_lock>& held, const char* acquiring) {
+        ostringstream os;
+        os << "thread " << this_thread::get_id() << " holds [";
+        for(size_t i = 0; i < held.size(); i++)
+            os << (i ? " -> " : "") << held[i].name;
+        os << "] and acquires " << acquiring;
+        return os.str();
+    }
+
+public:
+    // 加锁前调用：记录本线程持有的每把锁到 id 的边，发现环时抛出 lock_order_error
+    void before_lock(uint64_t id, const char* name) {
+        if(held_locks.empty())
+            return;
+        lock_guard<mutex> lock(mtx);
+        for(const held_lock& h : held_locks) {
+            if(h.id == id)
+                throw lock_order_error(describe_stack(held_locks, name) + ": recursive locking of " + name);
+            auto& out = edges[h.id];
+            if(out.count(id))
+                continue; // 已知的顺序，无需再查
+            vector<uint64_t> path;
+            unordered_set<uint64_t> visited;
+            if(find_path(id, h.id, path, visited)) {
+                ostringstream os;
+                os << "lock order inversion: " << name << " is acquired while holding " << h.name
+                   << ", but the opposite order was seen before\n"
+                   << "  current:  " << describe_stack(held_locks, name) << "\n";
+                for(size_t i = 0; i + 1 < path.size(); i++)
+                    os << "  previous: " << edges[path[i]][path[i + 1]] << "\n";
+                throw lock_order_error(os.str());
+            }
+            out.emplace(id, describe_stack(held_locks, name));
+        }
+    }
+
+    // 锁销毁时删除相关的边，id 不复用，所以只是为了回收内存
+    void remove(uint64_t id) {
+        lock_guard<mutex> lock(mtx);
+        edges.erase(id);
+        for(auto& [from, out] : edges)
+            out.erase(id);
+    }
+
+    // 清空图（测试用）
+    void reset() {
+        lock_guard<mutex> lock(mtx);
+        edges.clear();
+    }
+};
+
+lock_order_graph& lock_graph()
+{
+    static lock_order_graph graph;
+    return graph;
+}
+
+// ================= 带顺序检查的互斥锁 =================
+template<typename Mutex = mutex, typename Policy = default_lock_order_policy>
+class ordered_mutex;
+
+/*
+* @brief 检查模式：满足 Lockable 要求，可直接用于 lock_guard/unique_lock/scoped_lock
+* @param name：锁的名字，出现在报告中
+*/
+template<typename Mutex>
+class ordered_mutex<Mutex, lock_order_check>
+{
+    Mutex m;
+    const uint64_t id;
+    const char* name;
+
+    static uint64_t next_id() {
+        static atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    void pop_held() {
+        // 解锁顺序不一定与加锁顺序相反，从后往前找
+        for(auto it = held_locks.rbegin(); it != held_locks.rend(); ++it) {
+            if(it->id == id) {
+                held_locks.erase(next(it).base());
+                return;
+            }
+        }
+    }
+
+public:
+    explicit ordered_mutex(const char* lock_name = "mutex") : id(next_id()), name(lock_name) {}
+    ~ordered_mutex() { lock_graph().remove(id); }
+
+    ordered_mutex(const ordered_mutex&) = delete;
+    ordered_mutex& operator=(const ordered_mutex&) = delete;
+
+    void lock() {
+        lock_graph().before_lock(id, name); // 发现顺序问题时在真正阻塞之前抛出
+        m.lock();
+        held_locks.push_back({id, name});
+    }
+
+    // try_lock 不会阻塞，不会导致死锁，因此不记录顺序边，但成功后计入持锁栈
+    bool try_lock() {
+        if(!m.try_lock())
+            return false;
+        held_locks.push_back({id, name});
+        return true;
+    }
+
+    void unlock() {
+        pop_held();
+        m.unlock();
+    }
+};
+
+// 发布模式：直接转发，没有任何额外状态
+template<typename Mutex>
+class ordered_mutex<Mutex, no_lock_order_check>
+{
+    Mutex m;
+
+public:
+    explicit ordered_mutex(const char* = "mutex") {}
+
+    ordered_mutex(const ordered_mutex&) = delete;
+    ordered_mutex& operator=(const ordered_mutex&) = delete;
+
+    void lock() { m.lock(); }
+    bool try_lock() { return m.try_lock(); }
+    void unlock() { m.unlock(); }
+};
+
+static_assert(sizeof(ordered_mutex<mutex, no_lock_order_check>) == sizeof(mutex),
+              "release ordered_mutex must add no state");
+
+// ================= 示例与测试 =================
+/*
+    deadlock.cpp 的两个函数各执行一次，而且两个线程先后执行、没有重叠，真实情况下根本不会死锁，
+    但第二个函数加锁时就会被检查出与第一个函数相反的顺序。
+*/
+void demo_dead_lock() {
+    ordered_mutex<mutex, lock_order_check> t_lock1("t_lock1"), t_lock2("t_lock2");
+    int m_1 = 0, m_2 = 1;
+    auto dead_lock1 = [&]{
+        lock_guard<decltype(t_lock1)> l1(t_lock1);
+        m_1 = 1024;
+        lock_guard<decltype(t_lock2)> l2(t_lock2);
+        m_2 = 2048;
+    };
+    auto dead_lock2 = [&]{
+        lock_guard<decltype(t_lock2)> l2(t_lock2);
+        m_2 = 2048;
+        lock_guard<decltype(t_lock1)> l1(t_lock1);
+        m_1 = 1024;
+    };
+    thread t1(dead_lock1);
+    t1.join();
+    thread t2([&]{
+        try {
+            dead_lock2();
+        } catch(const lock_order_error& e) {
+            cout << e.what(); // 报告中包含两个线程各自的持锁栈
+        }
+    });
+    t2.join();
+    (void)m_1; (void)m_2;
+}
+
+void test_consistent_order() {
+    using checked = ordered_mutex<mutex, lock_order_check>;
+    checked a("a"), b("b"), c("c");
+    // 所有线程都按 a -> b -> c 的顺序，不报错
+    vector<thread> threads;
+    for(int t = 0; t < 4; t++)
+        threads.emplace_back([&]{
+            for(int i = 0; i < 1000; i++) {
+                scoped_lock<checked, checked> ab(a, b); // scoped_lock 内部可能用 try_lock 回退，不影响检查
+                lock_guard<checked> lc(c);
+            }
+        });
+    for(auto& t : threads) t.join();
+    {
+        lock_guard<checked> la(a);
+        lock_guard<checked> lc(c); // 跳过 b 也是一致的顺序
+    }
+    assert(held_locks.empty());
+    cout << "Consistent order test passed.\n";
+}
+
+void test_inversion_detected() {
+    using checked = ordered_mutex<mutex, lock_order_check>;
+    checked a("a"), b("b"), c("c");
+    {
+        lock_guard<checked> la(a);
+        lock_guard<checked> lb(b);
+    }
+    {
+        lock_guard<checked> lb(b);
+        lock_guard<checked> lc(c);
+    }
+    // a -> b -> c 已记录，c -> a 构成环（传递的相反顺序也能发现）
+    bool thrown = false;
+    {
+        lock_guard<checked> lc(c);
+        try {
+            lock_guard<checked> la(a);
+        } catch(const lock_order_error& e) {
+            thrown = true;
+            string report = e.what();
+            assert(report.find("acquires a") != string::npos);  // 当前的持锁栈
+            assert(report.find("holds [a] and acquires b") != string::npos); // 之前的持锁栈
+            assert(report.find("holds [b] and acquires c") != string::npos);
+        }
+    }
+    assert(thrown);
+    assert(held_locks.empty()); // 抛出时没有真正加锁，也没有计入持锁栈
+
+    // 重复加同一把锁
+    thrown = false;
+    {
+        lock_guard<checked> la(a);
+        try {
+            a.lock();
+        } catch(const lock_order_error&) {
+            thrown = true;
+        }
+    }
+    assert(thrown);
+    (void)thrown; // 定义 NDEBUG 时 assert 为空
+    cout << "Inversion detection test passed.\n";
+}
+
+/*
+    开销基准：单线程不争用时，一次 lock/unlock（单锁）以及嵌套加两把锁的耗时（ns）。
+    检查模式只在已持有其他锁时才访问锁顺序图，且已知的边只查一次哈希表。
+*/
+template<typename M>
+double lock_cost_ns(int nested, int iterations)
+{
+    M a("a"), b("b");
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++) {
+        a.lock();
+        if(nested) { b.lock(); b.unlock(); }
+        a.unlock();
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// 与 ordered_mutex 相同的构造接口，用于对照
+struct plain_mutex : mutex {
+    explicit plain_mutex(const char*) {}
+};
+
+void bench_lock_order_checker()
+{
+    const int kIterations = 5000000;
+    for(int nested : {0, 1}) {
+        cout << (nested ? "a -> b nested:" : "single lock:  ")
+             << "  std::mutex: " << lock_cost_ns<plain_mutex>(nested, kIterations) << " ns"
+             << "  release: " << lock_cost_ns<ordered_mutex<mutex, no_lock_order_check>>(nested, kIterations) << " ns"
+             << "  checked: " << lock_cost_ns<ordered_mutex<mutex, lock_order_check>>(nested, kIterations) << " ns" << endl;
+    }
+}
+
+int main()
+{
+    demo_dead_lock();
+    test_consistent_order();
+    test_inversion_detected();
+    // bench_lock_order_checker();
+
+    return 0;
+}
\ No newline at end of file
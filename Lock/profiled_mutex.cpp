@@ -0,0 +1,517 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <stack>
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+// g++ .\profiled_mutex.cpp -std=c++17 -O2 -pthread
+
+/*
+    锁争用分析：use_mutex.cpp 的 _mutex、条件变量示例中的 queue_mutex、share_mutex.cpp 的 rwMutex、
+    threadSafe.cpp 的 threadsafe_stack::mtx 等到底哪一把锁、在哪一行代码上等待最多，只靠猜测是看不出来的。
+    profiled_mutex<M> 包装任意互斥锁（需要时手动替换，不影响其他代码），按“锁名 + 加锁位置”统计：
+        加锁次数、争用次数（try_lock 失败后才阻塞的次数）、等待时间和持锁时间的直方图（按 2 的幂分桶，单位 ns）。
+    统计数据先累加在线程私有的表中，加锁路径上不访问任何共享的统计数据，分析器本身不会引入新的争用；
+    线程退出时把自己的数据合并到全局，snapshot() 汇总全局数据和仍在运行的线程的数据，按总等待时间排序。
+    加锁位置：lock() 的默认参数 __builtin_FILE()/__builtin_LINE() 记录调用处，
+    但经过 lock_guard/unique_lock 时记录的是标准库内部的位置，需要区分调用处时使用 profiled_guard。
+    profiled_mutex 不是 std::mutex，与条件变量一起使用时要换成 condition_variable_any。
+*/
+
+using profile_clock = chrono::steady_clock;
+
+constexpr int HIST_BUCKETS = 32; // 第 i 个桶：[2^(i-1), 2^i) ns，最后一个桶包含所有更大的值
+
+inline int hist_bucket(uint64_t ns)
+{
+    if(ns == 0)
+        return 0;
+    return min(HIST_BUCKETS - 1, 64 - __builtin_clzll(ns));
+}
+
+// 汇总后的统计（普通整数，用于快照）
+struct lock_counters {
+    uint64_t acquires = 0;
+    uint64_t contended = 0;
+    uint64_t wait_ns = 0;
+    uint64_t hold_ns = 0;
+    array<uint64_t, HIST_BUCKETS> wait_hist{};
+    array<uint64_t, HIST_BUCKETS> hold_hist{};
+
+    void add(const lock_counters& o) {
+        acquires += o.acquires;
+        contended += o.contended;
+        wait_ns += o.wait_ns;
+        hold_ns += o.hold_ns;
+        for(int i = 0; i < HIST_BUCKETS; i++) {
+            wait_hist[i] += o.wait_hist[i];
+            hold_hist[i] += o.hold_hist[i];
+        }
+    }
+
+    // 直方图的分位数，返回所在桶的上界（ns）
+    static uint64_t percentile(const array<uint64_t, HIST_BUCKETS>& hist, double p) {
+        uint64_t total = 0;
+        for(uint64_t c : hist) total += c;
+        if(total == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(p * (total - 1)), seen = 0;
+        for(int i = 0; i < HIST_BUCKETS; i++) {
+            seen += hist[i];
+            if(seen > rank)
+                return i == 0 ? 0 : uint64_t(1) << i;
+        }
+        return uint64_t(1) << (HIST_BUCKETS - 1);
+    }
+};
+
+/*
+    线程私有的统计：只有所属线程写，snapshot 可能同时读，所以用 relaxed 原子变量，
+    写入是“读-加-存”而不是 fetch_add（没有其他写者，不需要带 lock 前缀的原子指令）。
+*/
+struct site_stats {
+    atomic<uint64_t> acquires{0}, contended{0}, wait_ns{0}, hold_ns{0};
+    atomic<uint64_t> wait_hist[HIST_BUCKETS]{}, hold_hist[HIST_BUCKETS]{};
+
+    static void bump(atomic<uint64_t>& a, uint64_t v) {
+        a.store(a.load(memory_order_relaxed) + v, memory_order_relaxed);
+    }
+
+    void record_acquire(bool was_contended, uint64_t waited_ns) {
+        bump(acquires, 1);
+        if(was_contended) {
+            bump(contended, 1);
+            bump(wait_ns, waited_ns);
+        }
+        bump(wait_hist[hist_bucket(waited_ns)], 1);
+    }
+
+    void record_hold(uint64_t held_ns) {
+        bump(hold_ns, held_ns);
+        bump(hold_hist[hist_bucket(held_ns)], 1);
+    }
+
+    lock_counters load() const {
+        lock_counters c;
+        c.acquires = acquires.load(memory_order_relaxed);
+        c.contended = contended.load(memory_order_relaxed);
+        c.wait_ns = wait_ns.load(memory_order_relaxed);
+        c.hold_ns = hold_ns.load(memory_order_relaxed);
+        for(int i = 0; i < HIST_BUCKETS; i++) {
+            c.wait_hist[i] = wait_hist[i].load(memory_order_relaxed);
+            c.hold_hist[i] = hold_hist[i].load(memory_order_relaxed);
+        }
+        return c;
+    }
+};
+
+// 统计的键：锁名 + 加锁位置（都是字符串字面量，按指针比较即可，汇总时再按内容合并）
+struct lock_site_key {
+    const char* name;
+    const char* file;
+    int line;
+
+    bool operator==(const lock_site_key& o) const {
+        return name == o.name && file == o.file && line == o.line;
+    }
+};
+
+struct lock_site_key_hash {
+    size_t operator()(const lock_site_key& k) const {
+        size_t h = hash<const void*>()(k.name);
+        h = h * 31 + hash<const void*>()(k.file);
+        return h * 31 + static_cast<size_t>(k.line);
+    }
+};
+
+// 每个线程一张统计表
+class thread_lock_table
+{
+    mutex mtx; // 只在插入新条目和 snapshot 读取时使用，加锁路径上查找已有条目不加锁
+    unordered_map<lock_site_key, unique_ptr<site_stats>, lock_site_key_hash> sites;
+
+public:
+    thread_lock_table();
+    ~thread_lock_table();
+
+    site_stats& get(const char* name, const char* file, int line) {
+        lock_site_key key{name, file, line};
+        auto it = sites.find(key); // 只有本线程修改 sites，查找不需要加锁
+        if(it != sites.end())
+            return *it->second;
+        lock_guard<mutex> lock(mtx);
+        return *sites.emplace(key, make_unique<site_stats>()).first->second;
+    }
+
+    template<typename F>
+    void for_each(F f) {
+        lock_guard<mutex> lock(mtx);
+        for(auto& [key, stats] : sites)
+            f(key, stats->load());
+    }
+};
+
+// 快照：每把锁（按名字）的汇总以及各加锁位置的明细
+struct lock_site_report : lock_counters {
+    string file;
+    int line = 0;
+};
+
+struct lock_report : lock_counters {
+    string name;
+    vector<lock_site_report> sites; // 按等待时间从大到小
+};
+
+class lock_profiler
+{
+    mutex mtx;
+    vector<thread_lock_table*> live;                  // 仍在运行的线程
+    unordered_map<lock_site_key, lock_counters, lock_site_key_hash> retired; // 已退出线程的数据
+
+public:
+    static lock_profiler& instance() {
+        static lock_profiler profiler;
+        return profiler;
+    }
+
+    void attach(thread_lock_table* table) {
+        lock_guard<mutex> lock(mtx);
+        live.push_back(table);
+    }
+
+    void detach(thread_lock_table* table) {
+        lock_guard<mutex> lock(mtx);
+        table->for_each([&](const lock_site_key& key, const lock_counters& c) { retired[key].add(c); });
+        live.erase(find(live.begin(), live.end(), table));
+    }
+
+    vector<lock_report> snapshot() {
+        map<string, map<pair<string, int>, lock_counters>> merged;
+        auto collect = [&](const lock_site_key& key, const lock_counters& c) {
+            merged[key.name][{key.file, key.line}].add(c);
+        };
+        {
+            lock_guard<mutex> lock(mtx);
+            for(auto& [key, c] : retired)
+                collect(key, c);
+            for(thread_lock_table* table : live)
+                table->for_each(collect);
+        }
+        vector<lock_report> reports;
+        for(auto& [name, sites] : merged) {
+            lock_report r;
+            r.name = name;
+            for(auto& [site, c] : sites) {
+                lock_site_report s;
+                static_cast<lock_counters&>(s) = c;
+                s.file = site.first;
+                s.line = site.second;
+                r.add(c);
+                r.sites.push_back(move(s));
+            }
+            sort(r.sites.begin(), r.sites.end(), [](auto& a, auto& b) { return a.wait_ns > b.wait_ns; });
+            reports.push_back(move(r));
+        }
+        // 最“热”的锁排在前面：先比总等待时间，再比争用次数
+        sort(reports.begin(), reports.end(), [](auto& a, auto& b) {
+            return a.wait_ns != b.wait_ns ? a.wait_ns > b.wait_ns : a.contended > b.contended;
+        });
+        return reports;
+    }
+
+    void dump(ostream& os, size_t top_n = 10) {
+        vector<lock_report> reports = snapshot();
+        os << "---- lock contention (top " << min(top_n, reports.size()) << " of " << reports.size() << ") ----\n";
+        for(size_t i = 0; i < reports.size() && i < top_n; i++) {
+            const lock_report& r = reports[i];
+            os << r.name << ": acquires " << r.acquires << ", contended " << r.contended
+               << " (" << (r.acquires ? 100.0 * r.contended / r.acquires : 0.0) << "%)"
+               << ", wait " << r.wait_ns / 1000 << " us"
+               << ", wait p50/p99 " << lock_counters::percentile(r.wait_hist, 0.5) << "/"
+               << lock_counters::percentile(r.wait_hist, 0.99) << " ns"
+               << ", hold p50/p99 " << lock_counters::percentile(r.hold_hist, 0.5) << "/"
+               << lock_counters::percentile(r.hold_hist, 0.99) << " ns\n";
+            for(const lock_site_report& s : r.sites)
+                os << "    " << s.file << ":" << s.line << "  acquires " << s.acquires
+                   << ", contended " << s.contended << ", wait " << s.wait_ns / 1000 << " us\n";
+        }
+    }
+};
+
+inline thread_lock_table::thread_lock_table() { lock_profiler::instance().attach(this); }
+inline thread_lock_table::~thread_lock_table() { lock_profiler::instance().detach(this); }
+
+inline thread_lock_table& local_lock_table()
+{
+    thread_local thread_lock_table table;
+    return table;
+}
+
+// ================= 带统计的互斥锁 =================
+/*
+* @brief 满足 Lockable 要求；name 必须是生命周期足够长的字符串（通常是字面量），同名的锁合并统计
+*/
+template<typename Mutex = mutex>
+class profiled_mutex
+{
+    Mutex m;
+    const char* name;
+    // 以下两个成员只由持锁线程读写
+    site_stats* holder_stats = nullptr;
+    profile_clock::time_point acquired_at;
+
+    static uint64_t elapsed_ns(profile_clock::time_point from, profile_clock::time_point to) {
+        return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(to - from).count());
+    }
+
+public:
+    explicit profiled_mutex(const char* lock_name) : name(lock_name) {}
+
+    profiled_mutex(const profiled_mutex&) = delete;
+    profiled_mutex& operator=(const profiled_mutex&) = delete;
+
+    // 先 try_lock：不争用时只需一次取时间（记录持锁起点），争用时才测量等待时间
+    void lock(const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+        site_stats& stats = local_lock_table().get(name, file, line);
+        uint64_t waited = 0;
+        bool contended = !m.try_lock();
+        if(contended) {
+            auto start = profile_clock::now();
+            m.lock();
+            acquired_at = profile_clock::now();
+            waited = elapsed_ns(start, acquired_at);
+        } else {
+            acquired_at = profile_clock::now();
+        }
+        stats.record_acquire(contended, waited);
+        holder_stats = &stats;
+    }
+
+    bool try_lock(const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+        if(!m.try_lock())
+            return false;
+        acquired_at = profile_clock::now();
+        holder_stats = &local_lock_table().get(name, file, line);
+        holder_stats->record_acquire(false, 0);
+        return true;
+    }
+
+    void unlock() {
+        site_stats* stats = holder_stats;
+        uint64_t held = elapsed_ns(acquired_at, profile_clock::now());
+        m.unlock();
+        stats->record_hold(held); // 统计写在线程私有的表中，解锁后再写不会延长临界区
+    }
+};
+
+// 记录调用处位置的 lock_guard
+template<typename Mutex>
+class profiled_guard
+{
+    profiled_mutex<Mutex>& m;
+
+public:
+    explicit profiled_guard(profiled_mutex<Mutex>& mtx, const char* file = __builtin_FILE(), int line = __builtin_LINE())
+        : m(mtx) {
+        m.lock(file, line);
+    }
+    ~profiled_guard() { m.unlock(); }
+
+    profiled_guard(const profiled_guard&) = delete;
+    profiled_guard& operator=(const profiled_guard&) = delete;
+};
+
+// 周期性地把最热的几把锁输出到 os，析构时停止
+class periodic_lock_dump
+{
+    mutex mtx;
+    condition_variable cv;
+    bool stopped = false;
+    thread worker;
+
+public:
+    periodic_lock_dump(chrono::milliseconds interval, size_t top_n, ostream& os = cout) {
+        worker = thread([this, interval, top_n, &os]{
+            unique_lock<mutex> lock(mtx);
+            while(!cv.wait_for(lock, interval, [this]{ return stopped; })) {
+                lock.unlock();
+                lock_profiler::instance().dump(os, top_n);
+                lock.lock();
+            }
+        });
+    }
+
+    ~periodic_lock_dump() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopped = true;
+        }
+        cv.notify_one();
+        worker.join();
+    }
+};
+
+// ================= 示例与测试 =================
+const lock_report* find_report(const vector<lock_report>& reports, const string& name)
+{
+    for(const lock_report& r : reports)
+        if(r.name == name)
+            return &r;
+    return nullptr;
+}
+
+// threadSafe.cpp 中 threadsafe_stack 的简化版，只把 mtx 换成 profiled_mutex
+template<typename T>
+class profiled_stack {
+    stack<T> data;
+    profiled_mutex<> mtx{"threadsafe_stack::mtx"};
+
+public:
+    void push(T value) {
+        profiled_guard<mutex> lock(mtx);
+        data.push(move(value));
+    }
+
+    bool try_pop(T& value) {
+        profiled_guard<mutex> lock(mtx);
+        if(data.empty()) return false;
+        value = move(data.top());
+        data.pop();
+        return true;
+    }
+};
+
+void demo_profiled_mutex() {
+    profiled_stack<int> st;
+    profiled_mutex<> queue_mutex("queue_mutex");
+    long produced = 0;
+    periodic_lock_dump dumper(chrono::milliseconds(50), 5);
+    vector<thread> threads;
+    for(int t = 0; t < 4; t++)
+        threads.emplace_back([&, t]{
+            for(int i = 0; i < 20000; i++) {
+                if(t % 2 == 0) {
+                    st.push(i);
+                } else {
+                    int v;
+                    st.try_pop(v);
+                }
+                if(i % 100 == 0) {
+                    profiled_guard<mutex> lock(queue_mutex);
+                    produced++;
+                    this_thread::sleep_for(chrono::microseconds(50)); // 持锁时间长的锁
+                }
+            }
+        });
+    for(auto& t : threads) t.join();
+    lock_profiler::instance().dump(cout, 5);
+}
+
+void test_counts() {
+    profiled_mutex<> m("test_counts");
+    for(int i = 0; i < 100; i++) {
+        profiled_guard<mutex> lock(m);
+    }
+    for(int i = 0; i < 50; i++) {
+        lock_guard<profiled_mutex<>> lock(m); // 位置是标准库内部的某一行，与上面的调用处分开统计
+    }
+    assert(m.try_lock());
+    m.unlock();
+    auto reports = lock_profiler::instance().snapshot();
+    const lock_report* r = find_report(reports, "test_counts");
+    assert(r && r->acquires == 151 && r->contended == 0 && r->wait_ns == 0);
+    assert(r->sites.size() == 3);
+    uint64_t holds = 0;
+    for(uint64_t c : r->hold_hist) holds += c;
+    assert(holds == 151);
+    cout << "Count test passed.\n";
+}
+
+// 线程退出后数据合并到全局，不会丢失；持锁时睡眠制造争用
+void test_contention() {
+    profiled_mutex<> m("test_contention");
+    long counter = 0;
+    vector<thread> threads;
+    for(int t = 0; t < 4; t++)
+        threads.emplace_back([&]{
+            for(int i = 0; i < 200; i++) {
+                profiled_guard<mutex> lock(m);
+                counter++;
+                if(i % 10 == 0)
+                    this_thread::sleep_for(chrono::microseconds(200));
+            }
+        });
+    for(auto& t : threads) t.join();
+    auto reports = lock_profiler::instance().snapshot();
+    const lock_report* r = find_report(reports, "test_contention");
+    assert(r && r->acquires == 800 && counter == 800);
+    assert(r->contended > 0 && r->wait_ns > 0);
+    assert(r->sites.size() == 1 && r->sites[0].acquires == 800);
+    assert(lock_counters::percentile(r->hold_hist, 0.99) >= 100000); // 睡眠 200us 的那些持锁
+    cout << "Contention test passed (contended " << r->contended << " of " << r->acquires << ").\n";
+}
+
+/*
+    开销基准：单线程不争用时一次 lock/unlock 的耗时，以及 4 个线程争用同一把锁时的吞吐量。
+    不争用时额外的开销主要是两次 steady_clock::now()（记录持锁时间），查表和计数只占很小一部分；
+    争用时持锁区间因为取时间变长，吞吐量下降更明显，所以只在分析问题时替换成 profiled_mutex。
+*/
+template<typename Lock, typename Guard>
+double uncontended_ns(Lock& m, int iterations)
+{
+    auto start = profile_clock::now();
+    for(int i = 0; i < iterations; i++) {
+        Guard lock(m);
+    }
+    return chrono::duration<double, nano>(profile_clock::now() - start).count() / iterations;
+}
+
+template<typename Lock, typename Guard>
+double contended_mops(Lock& m, int threads, int ops_per_thread)
+{
+    long counter = 0;
+    vector<thread> workers;
+    auto start = profile_clock::now();
+    for(int t = 0; t < threads; t++)
+        workers.emplace_back([&]{
+            for(int i = 0; i < ops_per_thread; i++) {
+                Guard lock(m);
+                counter++;
+            }
+        });
+    for(auto& w : workers) w.join();
+    double s = chrono::duration<double>(profile_clock::now() - start).count();
+    return static_cast<double>(threads) * ops_per_thread / s / 1e6;
+}
+
+void bench_profiled_mutex()
+{
+    const int kIterations = 5000000;
+    mutex plain;
+    profiled_mutex<> profiled("bench");
+    cout << "uncontended lock/unlock:  std::mutex: " << uncontended_ns<mutex, lock_guard<mutex>>(plain, kIterations) << " ns"
+         << "  profiled_mutex: " << uncontended_ns<profiled_mutex<>, profiled_guard<mutex>>(profiled, kIterations) << " ns" << endl;
+    cout << "4 threads contended:      std::mutex: " << contended_mops<mutex, lock_guard<mutex>>(plain, 4, kIterations / 4) << " Mops/s"
+         << "  profiled_mutex: " << contended_mops<profiled_mutex<>, profiled_guard<mutex>>(profiled, 4, kIterations / 4) << " Mops/s" << endl;
+}
+
+int main()
+{
+    test_counts();
+    test_contention();
+    demo_profiled_mutex();
+    // bench_profiled_mutex();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <cassert>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// g++ .\spin_mutex.cpp -std=c++17 -O2 -pthread
+
+/*
+    use_mutex.cpp、deadlock.cpp 中只用了 std::mutex。临界区只有几十纳秒时，
+    拿不到锁就进内核睡眠（一次系统调用加上下文切换，微秒级）比临界区本身贵得多。
+    这里实现几种可以直接替换 std::mutex 的锁（满足 Lockable：lock/try_lock/unlock，可用于 lock_guard/scoped_lock）：
+        ttas_spinlock：先读后写（test-and-test-and-set）的自旋锁，失败后指数退避；
+        adaptive_mutex：先自旋一段时间，仍拿不到再用 futex 睡眠，自旋次数根据历史自动调整；
+        ticket_lock：排队取号，严格先来先服务（公平）；
+        mcs_lock：队列锁，每个等待者只在自己的节点上自旋，解锁时直接交给下一个等待者。
+    注意：纯自旋锁在线程数多于 CPU 核数时会很差（持锁线程被换出，其他线程白白自旋），
+    公平锁更严重：队首线程被换出时后面的线程都要等它。因此这里的等待循环自旋一段时间后都会 yield。
+*/
+
+// 自旋等待时提示 CPU（降低功耗，避免退出循环时的内存顺序冲突）
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// 指数退避：每次等待的 pause 次数翻倍，超过上限后改为让出 CPU
+class backoff
+{
+    static constexpr int MAX_PAUSES = 64;
+    int pauses = 1;
+
+public:
+    void pause() {
+        if(pauses <= MAX_PAUSES) {
+            for(int i = 0; i < pauses; i++)
+                cpu_relax();
+            pauses *= 2;
+        } else {
+            this_thread::yield();
+        }
+    }
+};
+
+// ================= TTAS 自旋锁 =================
+/*
+    直接用 exchange 自旋（TAS）时每次尝试都是一次写，锁所在的缓存行在各核之间来回传递；
+    TTAS 在锁被占用时只读（各核读自己缓存中的副本），看到锁释放后才尝试 exchange。
+*/
+class ttas_spinlock
+{
+    atomic<bool> locked{false};
+
+public:
+    void lock() {
+        backoff b;
+        while(locked.exchange(true, memory_order_acquire)) {
+            while(locked.load(memory_order_relaxed))
+                b.pause();
+        }
+    }
+
+    bool try_lock() {
+        return !locked.load(memory_order_relaxed) && !locked.exchange(true, memory_order_acquire);
+    }
+
+    void unlock() {
+        locked.store(false, memory_order_release);
+    }
+};
+
+// ================= 自旋后睡眠的自适应锁 =================
+#ifdef __linux__
+inline void futex_wait(atomic<int>& word, int expected)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake(atomic<int>& word, int count)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+#else
+// 没有 futex 的平台退化为让出 CPU 后重试
+inline void futex_wait(atomic<int>&, int) { this_thread::yield(); }
+inline void futex_wake(atomic<int>&, int) {}
+#endif
+
+/*
+    状态：0 未加锁，1 已加锁且没有睡眠的等待者，2 已加锁且可能有睡眠的等待者。
+    解锁时只有状态为 2 才需要系统调用唤醒，不争用时加锁和解锁都只是一次原子操作。
+    自旋上限参考 glibc 的 PTHREAD_MUTEX_ADAPTIVE_NP：记录最近几次拿到锁所需的自旋次数（滑动平均），
+    下次最多自旋其两倍；临界区短时很快在自旋阶段拿到锁，临界区长时自旋次数自动降下来，尽早睡眠。
+*/
+class adaptive_mutex
+{
+    static constexpr int MAX_SPINS = 100;
+    atomic<int> state{0};
+    atomic<int> avg_spins{0}; // 只是启发式的估计，不要求精确
+
+public:
+    void lock() {
+        int expected = 0;
+        if(state.compare_exchange_strong(expected, 1, memory_order_acquire))
+            return;
+        int avg = avg_spins.load(memory_order_relaxed);
+        int limit = min(MAX_SPINS, avg * 2 + 10);
+        for(int spins = 0; spins < limit; spins++) {
+            cpu_relax();
+            expected = 0;
+            if(state.load(memory_order_relaxed) == 0 &&
+               state.compare_exchange_strong(expected, 1, memory_order_acquire)) {
+                avg_spins.store(avg + (spins - avg) / 8, memory_order_relaxed);
+                return;
+            }
+        }
+        avg_spins.store(avg + (limit - avg) / 8, memory_order_relaxed);
+        // 自旋失败：把状态改为 2 再睡眠，醒来后仍以 2 的状态加锁（无法确定是否还有其他睡眠者）
+        int c = state.exchange(2, memory_order_acquire);
+        while(c != 0) {
+            futex_wait(state, 2);
+            c = state.exchange(2, memory_order_acquire);
+        }
+    }
+
+    bool try_lock() {
+        int expected = 0;
+        return state.compare_exchange_strong(expected, 1, memory_order_acquire);
+    }
+
+    void unlock() {
+        if(state.exchange(0, memory_order_release) == 2)
+            futex_wake(state, 1);
+    }
+};
+
+// ================= 排队自旋锁 =================
+/*
+    加锁时取号（next 加一），等到 serving 等于自己的号；解锁时 serving 加一。
+    按取号顺序获得锁，不会饥饿。等待时间与前面排队的人数成正比，所以按人数比例退避，减少对 serving 的读取。
+*/
+class ticket_lock
+{
+    alignas(64) atomic<unsigned> next{0};
+    alignas(64) atomic<unsigned> serving{0};
+
+public:
+    void lock() {
+        unsigned my = next.fetch_add(1, memory_order_relaxed);
+        int rounds = 0;
+        while(true) {
+            unsigned cur = serving.load(memory_order_acquire);
+            if(cur == my)
+                return;
+            if(++rounds > 8) {
+                this_thread::yield(); // 排在前面的线程可能已被换出
+            } else {
+                for(unsigned i = 0; i < (my - cur) * 16; i++)
+                    cpu_relax();
+            }
+        }
+    }
+
+    // 只有没人排队时才能拿到（next == serving），否则失败，不取号
+    bool try_lock() {
+        unsigned cur = serving.load(memory_order_relaxed);
+        unsigned expected = cur;
+        return next.compare_exchange_strong(expected, cur + 1, memory_order_acquire, memory_order_relaxed);
+    }
+
+    void unlock() {
+        // 只有持锁线程修改 serving
+        serving.store(serving.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+};
+
+// ================= MCS 队列锁 =================
+/*
+    等待者排成链表，tail 指向队尾。加锁时把自己的节点 exchange 到队尾，挂到前驱的 next 上，
+    然后只在自己节点的 locked 上自旋；解锁时把下一个节点的 locked 置为 false。
+    每个线程自旋的是不同的缓存行（自己的节点，最好在自己的 NUMA 节点内存上），
+    解锁只写一个等待者的缓存行，而不是让所有等待者同时失效重读，锁交接的流量与等待者数量无关。
+    标准的 Lockable 接口不能传入节点，所以节点从线程私有的节点池中取，加锁后记在锁的 holder 中，解锁时归还。
+*/
+class mcs_lock
+{
+    struct alignas(64) mcs_node {
+        atomic<mcs_node*> next{nullptr};
+        atomic<bool> locked{false};
+    };
+
+    // 线程私有的空闲节点，线程同时持有多把 MCS 锁时每把各用一个节点
+    struct node_pool {
+        vector<mcs_node*> free_nodes;
+        ~node_pool() {
+            for(mcs_node* n : free_nodes)
+                delete n;
+        }
+        mcs_node* get() {
+            if(free_nodes.empty())
+                return new mcs_node;
+            mcs_node* n = free_nodes.back();
+            free_nodes.pop_back();
+            return n;
+        }
+        void put(mcs_node* n) { free_nodes.push_back(n); }
+    };
+
+    static node_pool& pool() {
+        thread_local node_pool p;
+        return p;
+    }
+
+    atomic<mcs_node*> tail{nullptr};
+    mcs_node* holder = nullptr; // 当前持锁线程的节点，只由持锁线程读写
+
+public:
+    void lock() {
+        mcs_node* me = pool().get();
+        me->next.store(nullptr, memory_order_relaxed);
+        me->locked.store(true, memory_order_relaxed);
+        mcs_node* prev = tail.exchange(me, memory_order_acq_rel);
+        if(prev) {
+            prev->next.store(me, memory_order_release);
+            backoff b;
+            while(me->locked.load(memory_order_acquire))
+                b.pause();
+        }
+        holder = me;
+    }
+
+    bool try_lock() {
+        mcs_node* me = pool().get();
+        me->next.store(nullptr, memory_order_relaxed);
+        mcs_node* expected = nullptr;
+        if(tail.compare_exchange_strong(expected, me, memory_order_acq_rel, memory_order_relaxed)) {
+            holder = me;
+            return true;
+        }
+        pool().put(me);
+        return false;
+    }
+
+    void unlock() {
+        mcs_node* me = holder;
+        mcs_node* succ = me->next.load(memory_order_acquire);
+        if(!succ) {
+            mcs_node* expected = me;
+            if(tail.compare_exchange_strong(expected, nullptr, memory_order_acq_rel, memory_order_relaxed)) {
+                pool().put(me);
+                return;
+            }
+            // 有新的等待者已经 exchange 了 tail，但还没挂到 next 上，等它挂上
+            backoff b;
+            while(!(succ = me->next.load(memory_order_acquire)))
+                b.pause();
+        }
+        succ->locked.store(false, memory_order_release);
+        pool().put(me); // 交接之后不会再有人访问 me
+    }
+};
+
+// ================= 测试 =================
+/*
+    互斥性测试：临界区内对两个普通变量做非原子的加法，并检查临界区内没有别的线程。
+*/
+template<typename Lock>
+void test_mutual_exclusion(const char* name)
+{
+    Lock m;
+    long counter = 0, shadow = 0;
+    atomic<int> inside(0);
+    vector<thread> threads;
+    const int kThreads = 4, kIterations = 20000;
+    for(int t = 0; t < kThreads; t++)
+        threads.emplace_back([&]{
+            for(int i = 0; i < kIterations; i++) {
+                lock_guard<Lock> lock(m);
+                assert(inside.fetch_add(1, memory_order_relaxed) == 0);
+                counter++;
+                shadow = counter;
+                inside.fetch_sub(1, memory_order_relaxed);
+            }
+        });
+    for(auto& t : threads) t.join();
+    assert(counter == kThreads * kIterations && shadow == counter);
+    cout << name << " mutual exclusion test passed.\n";
+}
+
+template<typename Lock>
+void test_try_lock(const char* name)
+{
+    Lock m;
+    assert(m.try_lock());
+    thread other([&]{ assert(!m.try_lock()); });
+    other.join();
+    m.unlock();
+    // scoped_lock 同时锁两把锁时会用到 try_lock
+    Lock m2;
+    {
+        scoped_lock<Lock, Lock> both(m, m2);
+    }
+    assert(m.try_lock() && m2.try_lock());
+    m.unlock();
+    m2.unlock();
+    cout << name << " try_lock test passed.\n";
+}
+
+// 持锁时间较长（毫秒级）时，adaptive_mutex 的等待者应睡眠而不是一直自旋，并且能被正确唤醒
+void test_adaptive_mutex_parks()
+{
+    adaptive_mutex m;
+    int value = 0;
+    m.lock();
+    vector<thread> waiters;
+    for(int t = 0; t < 3; t++)
+        waiters.emplace_back([&]{
+            lock_guard<adaptive_mutex> lock(m);
+            value++;
+        });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    value = 100;
+    m.unlock();
+    for(auto& t : waiters) t.join();
+    assert(value == 103);
+    cout << "adaptive_mutex park/wake test passed.\n";
+}
+
+// 多把 MCS 锁嵌套，且解锁顺序与加锁顺序不同
+void test_mcs_nested()
+{
+    mcs_lock a, b, c;
+    long sum = 0;
+    vector<thread> threads;
+    for(int t = 0; t < 3; t++)
+        threads.emplace_back([&]{
+            for(int i = 0; i < 5000; i++) {
+                a.lock();
+                b.lock();
+                c.lock();
+                a.unlock();
+                sum++;
+                c.unlock();
+                b.unlock();
+            }
+        });
+    for(auto& t : threads) t.join();
+    assert(sum == 15000);
+    cout << "mcs_lock nested test passed.\n";
+}
+
+/*
+    基准：threads 个线程各做 ops 次“加锁 -> 临界区 -> 解锁 -> 非临界区”，
+    临界区对共享数组做 cs_len 次读写，非临界区做同样长度的本地计算，单位 Mops/s。
+    临界区越短，锁本身的开销（以及是否进内核）占比越大。
+*/
+template<typename Lock>
+double lock_throughput(int threads, int cs_len, int ops_per_thread)
+{
+    Lock m;
+    vector<long> shared_data(64, 0);
+    atomic<bool> go(false);
+    atomic<long> sink(0);
+    vector<thread> workers;
+    for(int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]{
+            long local = t;
+            while(!go) this_thread::yield();
+            for(int i = 0; i < ops_per_thread; i++) {
+                {
+                    lock_guard<Lock> lock(m);
+                    for(int k = 0; k < cs_len; k++)
+                        shared_data[k & 63] += k;
+                    shared_data[0]++;
+                }
+                for(int k = 0; k < cs_len; k++)
+                    local = local * 31 + k;
+            }
+            sink += local;
+        });
+    auto start = chrono::steady_clock::now();
+    go = true;
+    for(auto& w : workers) w.join();
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    assert(shared_data[0] >= static_cast<long>(threads) * ops_per_thread);
+    return static_cast<double>(threads) * ops_per_thread / s / 1e6;
+}
+
+void bench_spin_mutex()
+{
+    const int kOpsPerThread = 100000;
+    cout << "cpus = " << thread::hardware_concurrency() << endl;
+    for(int cs_len : {0, 16, 256}) {
+        cout << "---- critical section = " << cs_len << " ----\n";
+        for(int threads = 1; threads <= 8; threads *= 2)
+            cout << "threads = " << threads
+                 << "  std::mutex: " << lock_throughput<mutex>(threads, cs_len, kOpsPerThread)
+                 << "  ttas: " << lock_throughput<ttas_spinlock>(threads, cs_len, kOpsPerThread)
+                 << "  adaptive: " << lock_throughput<adaptive_mutex>(threads, cs_len, kOpsPerThread)
+                 << "  ticket: " << lock_throughput<ticket_lock>(threads, cs_len, kOpsPerThread)
+                 << "  mcs: " << lock_throughput<mcs_lock>(threads, cs_len, kOpsPerThread) << " Mops/s" << endl;
+    }
+}
+
+int main()
+{
+    test_mutual_exclusion<ttas_spinlock>("ttas_spinlock");
+    test_mutual_exclusion<adaptive_mutex>("adaptive_mutex");
+    test_mutual_exclusion<ticket_lock>("ticket_lock");
+    test_mutual_exclusion<mcs_lock>("mcs_lock");
+    test_try_lock<ttas_spinlock>("ttas_spinlock");
+    test_try_lock<adaptive_mutex>("adaptive_mutex");
+    test_try_lock<ticket_lock>("ticket_lock");
+    test_try_lock<mcs_lock>("mcs_lock");
+    test_adaptive_mutex_parks();
+    test_mcs_nested();
+    // bench_spin_mutex();
+
+    return 0;
+}
\ No newline at end of file
@@ -7,14 +7,28 @@
 #include <thread>
 #include <assert.h>
 #include <atomic>
+#include <optional>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include <random>
+#include <iterator>
+#include <algorithm>
 using namespace std;
 
+// g++ .\threadSafe.cpp -std=c++17 -pthread
+
 // 线程安全的栈模板类
 template<typename T>
 class threadsafe_stack {
 private:
     std::stack<T> data;   // 底层存储数据的栈
     mutable std::mutex mtx; // 互斥锁（mutable允许在const方法中加锁）
+    std::condition_variable cond; // 栈由空变为非空时唤醒 wait_and_pop 的等待者
 
 public:
     threadsafe_stack() = default;
@@ -29,8 +43,11 @@ public:
 
     // 压栈操作（线程安全）
     void push(T new_value) {
-        std::lock_guard<std::mutex> lock(mtx);
-        data.push(std::move(new_value)); // 使用move避免拷贝
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            data.push(std::move(new_value)); // 使用move避免拷贝
+        }
+        cond.notify_one(); // 解锁后再通知，被唤醒的线程不必立刻又阻塞在锁上
     }
 
     // 弹栈操作（返回智能指针，异常安全）
@@ -50,6 +67,90 @@ public:
         data.pop();
     }
 
+    // 非阻塞弹栈：栈空时返回 std::nullopt，不抛异常（轮询场景下比捕获异常便宜得多）
+    std::optional<T> try_pop() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (data.empty()) return std::nullopt;
+        std::optional<T> res(std::move(data.top()));
+        data.pop();
+        return res;
+    }
+
+    // 非阻塞弹栈（通过引用返回结果）：既不抛异常也不分配内存，栈空返回 false
+    bool try_pop(T& value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (data.empty()) return false;
+        value = std::move(data.top());
+        data.pop();
+        return true;
+    }
+
+    // 批量压栈：整批只加一次锁，[first, last) 中的元素依次压栈（最后一个在栈顶）
+    template<typename InputIt>
+    void push_range(InputIt first, InputIt last) {
+        size_t n = 0;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (; first != last; ++first, ++n)
+                data.push(*first);
+        }
+        if (n == 1) cond.notify_one();
+        else if (n > 1) cond.notify_all(); // 可能有多个等待者都能取到数据
+    }
+
+    // 批量弹栈：整批只加一次锁，最多弹出 max_n 个元素写入 out（先写栈顶），返回实际弹出的个数
+    template<typename OutputIt>
+    size_t pop_many(OutputIt out, size_t max_n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t n = 0;
+        for (; n < max_n && !data.empty(); ++n) {
+            *out++ = std::move(data.top());
+            data.pop();
+        }
+        return n;
+    }
+
+    // 阻塞弹栈：栈空时在条件变量上等待，不占用CPU
+    void wait_and_pop(T& value) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this]{ return !data.empty(); });
+        value = std::move(data.top());
+        data.pop();
+    }
+
+    // 带超时的阻塞弹栈：超时仍为空则返回 std::nullopt
+    template<typename Rep, typename Period>
+    std::optional<T> wait_and_pop_for(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!cond.wait_for(lock, timeout, [this]{ return !data.empty(); }))
+            return std::nullopt;
+        std::optional<T> res(std::move(data.top()));
+        data.pop();
+        return res;
+    }
+
+    // 不等待锁的压栈/弹栈：锁正被其他线程持有时立即返回 busy（供 elimination_stack 在竞争时改走消除数组）
+    enum class attempt { success, empty, busy };
+
+    // 压栈成功后 value 已被移走；返回 busy 时 value 保持不变
+    attempt try_lock_push(T& value) {
+        std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+        if (!lock.owns_lock()) return attempt::busy;
+        data.push(std::move(value));
+        lock.unlock();
+        cond.notify_one();
+        return attempt::success;
+    }
+
+    attempt try_lock_pop(T& value) {
+        std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+        if (!lock.owns_lock()) return attempt::busy;
+        if (data.empty()) return attempt::empty;
+        value = std::move(data.top());
+        data.pop();
+        return attempt::success;
+    }
+
     // 检查栈是否为空（线程安全）
     bool empty() const {
         std::lock_guard<std::mutex> lock(mtx);
@@ -63,6 +164,135 @@ public:
     }
 };
 
+/*
+    消除回退栈（elimination-backoff stack）：
+        push 和 pop 互为逆操作，一对同时发生的 push/pop 可以直接交换数据，不必经过栈本身（“相互消除”）。
+        线程先尝试不等待地获取中心栈的锁；锁被占用（说明有竞争）时不排队，而是随机选一个消除槽：
+            push：把值放进空槽，等待一小段时间，期间若有 pop 取走则完成；超时则取回值重新尝试中心栈；
+            pop：找到有 push 在等待的槽，直接取走其中的值。
+        竞争越激烈，消除的成功率越高，中心栈的锁反而越不容易成为瓶颈。
+    消除数组的有效范围自适应：槽被占用（冲突）时扩大，等待超时无人配对时缩小。
+*/
+template<typename T>
+class elimination_stack {
+private:
+    static constexpr int MAX_SLOTS = 32; // 消除数组最大长度
+    static constexpr int WAIT_SPINS = 256; // push 在槽中等待配对的轮数
+
+    enum slot_state { EMPTY, BUSY, WAITING, TAKEN };
+
+    // 每个槽独占一个缓存行，避免相邻槽之间的伪共享
+    struct alignas(64) exchange_slot {
+        std::atomic<int> state{EMPTY};
+        std::optional<T> value; // 只由当前独占该槽的线程（BUSY 的 push 或抢到 WAITING 的 pop）读写
+    };
+
+    threadsafe_stack<T> stack; // 中心栈
+    exchange_slot slots[MAX_SLOTS];
+    std::atomic<int> range{1}; // 当前使用的槽数 [1, MAX_SLOTS]
+
+    static int random_index(int n) {
+        thread_local std::minstd_rand rng(std::random_device{}());
+        return static_cast<int>(rng() % n);
+    }
+
+    void grow() {
+        int r = range.load(std::memory_order_relaxed);
+        if (r < MAX_SLOTS) range.compare_exchange_weak(r, r + 1, std::memory_order_relaxed);
+    }
+
+    void shrink() {
+        int r = range.load(std::memory_order_relaxed);
+        if (r > 1) range.compare_exchange_weak(r, r - 1, std::memory_order_relaxed);
+    }
+
+    // push 一侧的消除：成功被 pop 取走返回 true；否则值留在 value 中返回 false
+    bool eliminate_push(T& value) {
+        exchange_slot& slot = slots[random_index(range.load(std::memory_order_relaxed))];
+        int expected = EMPTY;
+        if (!slot.state.compare_exchange_strong(expected, BUSY, std::memory_order_acquire)) {
+            grow(); // 槽被占用，说明竞争激烈
+            return false;
+        }
+        slot.value.emplace(std::move(value));
+        slot.state.store(WAITING, std::memory_order_release);
+
+        for (int i = 0; i < WAIT_SPINS; ++i) {
+            if (slot.state.load(std::memory_order_acquire) == TAKEN) {
+                slot.state.store(EMPTY, std::memory_order_release);
+                return true;
+            }
+            if (i % 16 == 15) std::this_thread::yield();
+        }
+
+        // 超时：撤回等待；若撤回失败说明 pop 恰好在这时取走了值
+        expected = WAITING;
+        if (slot.state.compare_exchange_strong(expected, BUSY, std::memory_order_acquire)) {
+            value = std::move(*slot.value);
+            slot.value.reset();
+            slot.state.store(EMPTY, std::memory_order_release);
+            shrink(); // 无人配对，说明竞争不激烈
+            return false;
+        }
+        while (slot.state.load(std::memory_order_acquire) != TAKEN)
+            std::this_thread::yield(); // pop 正在取值（TAKEN 之前的短暂中间态）
+        slot.state.store(EMPTY, std::memory_order_release);
+        return true;
+    }
+
+    // pop 一侧的消除：找到正在等待的 push 就取走它的值
+    bool eliminate_pop(T& value) {
+        exchange_slot& slot = slots[random_index(range.load(std::memory_order_relaxed))];
+        int expected = WAITING;
+        if (!slot.state.compare_exchange_strong(expected, BUSY, std::memory_order_acquire))
+            return false;
+        value = std::move(*slot.value);
+        slot.value.reset();
+        slot.state.store(TAKEN, std::memory_order_release);
+        return true;
+    }
+
+public:
+    elimination_stack() = default;
+    elimination_stack(const elimination_stack&) = delete;
+    elimination_stack& operator=(const elimination_stack&) = delete;
+
+    void push(T new_value) {
+        while (true) {
+            if (stack.try_lock_push(new_value) == threadsafe_stack<T>::attempt::success) return;
+            if (eliminate_push(new_value)) return;
+        }
+    }
+
+    // 栈空时返回 std::nullopt
+    std::optional<T> try_pop() {
+        T value;
+        while (true) {
+            auto r = stack.try_lock_pop(value);
+            if (r == threadsafe_stack<T>::attempt::success) return value;
+            if (r == threadsafe_stack<T>::attempt::empty) return std::nullopt;
+            if (eliminate_pop(value)) return value;
+        }
+    }
+
+    std::shared_ptr<T> pop() {
+        auto v = try_pop();
+        if (!v) throw std::out_of_range("Stack is empty!");
+        return std::make_shared<T>(std::move(*v));
+    }
+
+    void pop(T& value) {
+        auto v = try_pop();
+        if (!v) throw std::out_of_range("Stack is empty!");
+        value = std::move(*v);
+    }
+
+    // 不计正在消除数组中等待的元素
+    bool empty() const { return stack.empty(); }
+    size_t size() const { return stack.size(); }
+    int elimination_range() const { return range.load(); }
+};
+
 void test_threadsafe_stack() {
     threadsafe_stack<int> safe_stack;
     safe_stack.push(1);
@@ -131,26 +361,47 @@ void test_exception_safety() {
     std::cout << "Exception safety test passed.\n";
 }
 
-// 多线程并发测试
-void test_concurrent_access() {
+// 消费者取数据的方式
+enum class pop_mode {
+    exception_polling, // pop() 栈空抛异常，捕获后 yield 重试
+    try_pop_polling,   // try_pop() 栈空返回 nullopt，yield 重试
+    blocking           // wait_and_pop_for() 栈空时在条件变量上休眠
+};
+
+// 进程CPU时间（毫秒），包含所有线程。Windows 上的 std::clock() 返回的是墙上时间，不能用来比较CPU消耗
+double process_cpu_ms() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto to_100ns = [](const FILETIME& t) {
+        return (static_cast<unsigned long long>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (to_100ns(kernel) + to_100ns(user)) / 10000.0; // FILETIME 的单位是 100ns
+#else
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/*
+    生产者每压入 100 个元素休眠 1ms，模拟突发式生产，消费者大部分时间面对空栈；
+    返回这段时间进程消耗的CPU时间，用来比较不同等待方式空转浪费的CPU。
+*/
+double run_concurrent_access(pop_mode mode) {
     threadsafe_stack<int> stack;
     const int kNumThreads = 4;
     const int kPushesPerThread = 1000;
     std::vector<std::thread> threads;
+    double cpu_start = process_cpu_ms();
 
     // 启动生产者线程（并发压栈）
     for (int i = 0; i < kNumThreads; ++i) {
         threads.emplace_back([&] {
             for (int j = 0; j < kPushesPerThread; ++j) {
                 stack.push(j);
-                // 添加线程日志
-                // static std::mutex print_mutex;
-                // {
-                //     std::lock_guard<std::mutex> lock(print_mutex);
-                //     std::cout << "Thread " << std::this_thread::get_id() 
-                //             << " pushed value: " << j << std::endl;
-                //     this_thread::sleep_for(1s);
-                // }
+                if (j % 100 == 99)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
         });
     }
@@ -160,11 +411,26 @@ void test_concurrent_access() {
     for (int i = 0; i < kNumThreads; ++i) {
         threads.emplace_back([&] {
             while (pop_count < kNumThreads * kPushesPerThread) {
-                try {
-                    stack.pop();
-                    ++pop_count;
-                } catch (const std::out_of_range&) {
-                    std::this_thread::yield(); // 避免忙等待
+                switch (mode) {
+                case pop_mode::exception_polling:
+                    try {
+                        stack.pop();
+                        ++pop_count;
+                    } catch (const std::out_of_range&) {
+                        std::this_thread::yield(); // 避免忙等待
+                    }
+                    break;
+                case pop_mode::try_pop_polling:
+                    if (stack.try_pop())
+                        ++pop_count;
+                    else
+                        std::this_thread::yield();
+                    break;
+                case pop_mode::blocking:
+                    // 带超时等待：全部元素都被其他消费者取走后，靠超时醒来检查退出条件
+                    if (stack.wait_and_pop_for(std::chrono::milliseconds(10)))
+                        ++pop_count;
+                    break;
                 }
             }
         });
@@ -175,15 +441,189 @@ void test_concurrent_access() {
     // 验证最终栈为空
     assert(stack.empty());
     assert(pop_count == kNumThreads * kPushesPerThread);
+    return process_cpu_ms() - cpu_start;
+}
+
+// 多线程并发测试：对比三种消费方式的CPU开销
+void test_concurrent_access() {
+    double cpu_exception = run_concurrent_access(pop_mode::exception_polling);
+    double cpu_try_pop = run_concurrent_access(pop_mode::try_pop_polling);
+    double cpu_blocking = run_concurrent_access(pop_mode::blocking);
+
+    std::cout << "CPU time  exception polling: " << cpu_exception << " ms"
+              << "  try_pop polling: " << cpu_try_pop << " ms"
+              << "  wait_and_pop: " << cpu_blocking << " ms\n";
     std::cout << "Concurrent access test passed.\n";
 }
 
+// 非阻塞/阻塞弹栈接口测试
+void test_try_pop_and_wait() {
+    threadsafe_stack<int> stack;
+    assert(!stack.try_pop());
+    assert(!stack.wait_and_pop_for(std::chrono::milliseconds(1)));
+
+    stack.push(1);
+    auto v = stack.try_pop();
+    assert(v && *v == 1);
+
+    // 消费者先阻塞，生产者稍后压栈将其唤醒
+    int value = 0;
+    std::thread consumer([&] { stack.wait_and_pop(value); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stack.push(42);
+    consumer.join();
+    assert(value == 42);
+    assert(stack.empty());
+    std::cout << "try_pop/wait_and_pop test passed.\n";
+}
+
+// 消除栈正确性：每个值恰好被弹出一次
+void test_elimination_stack() {
+    elimination_stack<int> stack;
+    const int kNumThreads = 8;
+    const int kPushesPerThread = 20000;
+    const int kTotal = kNumThreads * kPushesPerThread;
+    std::vector<std::atomic<int>> seen(kTotal);
+    std::atomic<int> pop_count(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < kNumThreads; ++i) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < kPushesPerThread; ++j)
+                stack.push(i * kPushesPerThread + j);
+        });
+        threads.emplace_back([&] {
+            while (pop_count < kTotal) {
+                if (auto v = stack.try_pop()) {
+                    seen[*v]++;
+                    ++pop_count;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    assert(stack.empty());
+    for (auto& s : seen)
+        assert(s == 1);
+    std::cout << "Elimination stack test passed (final range " << stack.elimination_range() << ").\n";
+}
+
+// 每个线程交替 push/try_pop，返回总吞吐量（Mops/s）
+template<typename Stack>
+double stack_throughput(int num_threads, int ops_per_thread) {
+    Stack stack;
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&] {
+            while (!go) std::this_thread::yield();
+            for (int i = 0; i < ops_per_thread / 2; ++i) {
+                stack.push(i);
+                stack.try_pop();
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& t : threads) t.join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(num_threads) * ops_per_thread / s / 1e6;
+}
+
+// 线程数从 1 增加到 64：互斥锁版本在竞争下吞吐量不再增长，消除栈依靠 push/pop 配对继续扩展
+void bench_elimination_stack() {
+    const int kOpsPerThread = 200000;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        std::cout << "threads = " << threads
+                  << "  mutex: " << stack_throughput<threadsafe_stack<int>>(threads, kOpsPerThread) << " Mops/s"
+                  << "  elimination: " << stack_throughput<elimination_stack<int>>(threads, kOpsPerThread) << " Mops/s"
+                  << std::endl;
+    }
+}
+
+// 批量接口测试
+void test_batch_operations() {
+    threadsafe_stack<int> stack;
+    std::vector<int> in = {1, 2, 3, 4, 5};
+    stack.push_range(in.begin(), in.end());
+    assert(stack.size() == 5);
+
+    std::vector<int> out(3);
+    assert(stack.pop_many(out.begin(), 3) == 3);
+    assert((out == std::vector<int>{5, 4, 3}));
+
+    std::vector<int> rest;
+    assert(stack.pop_many(std::back_inserter(rest), 10) == 2);
+    assert((rest == std::vector<int>{2, 1}));
+    assert(stack.pop_many(std::back_inserter(rest), 10) == 0);
+
+    int value;
+    assert(!stack.try_pop(value));
+    stack.push(7);
+    assert(stack.try_pop(value) && value == 7);
+    std::cout << "Batch operations test passed.\n";
+}
+
+/*
+    批量大小基准：4 个生产者、4 个消费者，按不同批量大小传递同样数量的元素，统计每秒传递的元素数。
+    批量为 1 时使用逐个的 push/try_pop（不经过批量接口、不分配内存），作为对照。
+*/
+double batch_throughput(size_t batch) {
+    threadsafe_stack<int> stack;
+    const int kNumThreads = 4;
+    const size_t kItemsPerThread = 1 << 18;
+    const size_t kTotal = kNumThreads * kItemsPerThread;
+    std::atomic<size_t> popped(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kNumThreads; ++i) {
+        threads.emplace_back([&] {
+            std::vector<int> buf(batch);
+            for (size_t j = 0; j < kItemsPerThread; j += batch) {
+                if (batch == 1) {
+                    stack.push(static_cast<int>(j));
+                } else {
+                    size_t n = std::min(batch, kItemsPerThread - j);
+                    for (size_t k = 0; k < n; ++k) buf[k] = static_cast<int>(j + k);
+                    stack.push_range(buf.begin(), buf.begin() + n);
+                }
+            }
+        });
+        threads.emplace_back([&] {
+            std::vector<int> buf(batch);
+            int value;
+            while (popped < kTotal) {
+                size_t n = (batch == 1) ? (stack.try_pop(value) ? 1 : 0) : stack.pop_many(buf.begin(), batch);
+                if (n) popped += n;
+                else std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return kTotal / s / 1e6;
+}
+
+void bench_batch_operations() {
+    for (size_t batch = 1; batch <= 1024; batch *= 4)
+        std::cout << "batch = " << batch << "  " << batch_throughput(batch) << " M items/s" << std::endl;
+}
+
 int main()
 {
     // test_threadsafe_stack();
     // test_basic_operations();
     // test_exception_safety();
+    test_try_pop_and_wait();
     test_concurrent_access();
+    test_elimination_stack();
+    test_batch_operations();
+    // bench_elimination_stack();
+    // bench_batch_operations();
 
     return 0;
 }
\ No newline at end of file
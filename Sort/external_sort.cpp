@@ -0,0 +1,417 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <filesystem>
+#include <type_traits>
+#include "generic_sort.hpp"
+using namespace std;
+
+// g++ .\external_sort.cpp -std=c++17 -O2 -pthread
+
+/*
+    外部排序（数据量大于内存）：
+        1. 生成顺串：每次读入内存预算能容纳的一段数据，用快速排序（gsort::sort）排好后写到临时文件；
+        2. 多路归并：用败者树对 k 个顺串做 k 路归并，每个顺串和输出各配一个大块顺序读写缓冲区；
+           顺串数超过一次能归并的路数时，先归并成更少、更长的顺串，再继续归并。
+    文件内容是 T 的原始二进制数组，T 必须是可平凡拷贝的类型。
+*/
+
+struct external_sort_options {
+    size_t memory_bytes = size_t(256) << 20;   // 内存预算：生成顺串时一次读入的数据量，也决定归并路数
+    size_t io_buffer_bytes = size_t(4) << 20;  // 每个读/写缓冲区的大小，越大顺序 I/O 越高效
+    string temp_dir;                           // 临时文件目录，为空时使用系统临时目录
+};
+
+// 进度与吞吐量计数器：排序线程更新，其他线程可以随时无锁读取
+struct external_sort_progress {
+    atomic<uint64_t> input_bytes{0};   // 输入文件大小
+    atomic<uint64_t> bytes_read{0};    // 累计读取字节数（包括归并时重复读取临时文件）
+    atomic<uint64_t> bytes_written{0}; // 累计写入字节数
+    atomic<uint64_t> runs_created{0};  // 已生成的初始顺串数
+    atomic<int> merge_passes{0};       // 已完成的归并趟数
+    atomic<bool> finished{false};
+    // 开始时间（steady_clock 的计数值），sort() 开始时重置，用原子变量保证监控线程读取时没有数据竞争
+    atomic<chrono::steady_clock::rep> start_ticks{chrono::steady_clock::now().time_since_epoch().count()};
+
+    void restart() {
+        start_ticks = chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    double elapsed_s() const {
+        chrono::steady_clock::duration since_start(chrono::steady_clock::now().time_since_epoch().count() - start_ticks.load());
+        return chrono::duration<double>(since_start).count();
+    }
+
+    // 读写总吞吐量（MB/s）
+    double throughput_mb_s() const {
+        double s = elapsed_s();
+        return s > 0 ? (bytes_read.load() + bytes_written.load()) / s / (1 << 20) : 0;
+    }
+};
+
+// 以独占方式持有 FILE*，关闭由析构函数负责
+class file_handle
+{
+    FILE* _f = nullptr;
+public:
+    file_handle(const string& path, const char* mode) : _f(fopen(path.c_str(), mode)) {
+        if(!_f)
+            throw runtime_error("cannot open " + path);
+        setvbuf(_f, nullptr, _IONBF, 0); // 缓冲由调用者自己管理
+    }
+    ~file_handle() { if(_f) fclose(_f); }
+    file_handle(const file_handle&) = delete;
+    file_handle& operator=(const file_handle&) = delete;
+    FILE* get() const { return _f; }
+};
+
+// 带大块缓冲的顺序读取器
+template<typename T>
+class run_reader
+{
+    file_handle _file;
+    vector<T> _buf;
+    size_t _pos = 0, _count = 0;
+    external_sort_progress& _progress;
+
+public:
+    run_reader(const string& path, size_t buffer_elems, external_sort_progress& progress)
+        : _file(path, "rb"), _buf(max<size_t>(buffer_elems, 1)), _progress(progress) {}
+
+    // 读取下一个元素，文件读完返回 false
+    bool next(T& value) {
+        if(_pos == _count) {
+            _count = fread(_buf.data(), sizeof(T), _buf.size(), _file.get());
+            _pos = 0;
+            if(_count == 0) {
+                if(ferror(_file.get()))
+                    throw runtime_error("read error");
+                return false;
+            }
+            _progress.bytes_read += _count * sizeof(T);
+        }
+        value = _buf[_pos++];
+        return true;
+    }
+};
+
+// 带大块缓冲的顺序写入器
+template<typename T>
+class run_writer
+{
+    file_handle _file;
+    vector<T> _buf;
+    size_t _count = 0;
+    external_sort_progress& _progress;
+
+public:
+    run_writer(const string& path, size_t buffer_elems, external_sort_progress& progress)
+        : _file(path, "wb"), _buf(max<size_t>(buffer_elems, 1)), _progress(progress) {}
+
+    ~run_writer() {
+        if(_count) fwrite(_buf.data(), sizeof(T), _count, _file.get()); // 析构中不抛异常，正常路径应显式调用 flush()
+    }
+
+    void push(const T& value) {
+        _buf[_count++] = value;
+        if(_count == _buf.size())
+            flush();
+    }
+
+    // 直接写出一整段已排序的数据（生成顺串时使用，不经过缓冲区）
+    void write(const T* data, size_t n) {
+        flush();
+        if(fwrite(data, sizeof(T), n, _file.get()) != n)
+            throw runtime_error("write error");
+        _progress.bytes_written += n * sizeof(T);
+    }
+
+    void flush() {
+        if(_count == 0)
+            return;
+        if(fwrite(_buf.data(), sizeof(T), _count, _file.get()) != _count)
+            throw runtime_error("write error");
+        _progress.bytes_written += _count * sizeof(T);
+        _count = 0;
+    }
+};
+
+/*
+    败者树：k 路归并时每次取出最小元素只需 log2(k) 次比较（堆需要约 2*log2(k) 次）。
+        _tree[1..k-1] 为内部节点，记录该节点比赛的“败者”（来源编号）；
+        _tree[0] 记录总冠军，即当前最小元素所在的来源；
+        叶子 i 在逻辑上位于 k + i，取走冠军后只需沿叶子到根的路径重新比赛。
+    已经读完的来源视为正无穷。
+*/
+template<typename T>
+class loser_tree
+{
+    vector<int> _tree;
+    vector<T> _keys;
+    vector<bool> _done;
+    int _k;
+
+    // 来源 a 的当前元素是否应排在来源 b 之前
+    bool before(int a, int b) const {
+        if(_done[a]) return false;
+        if(_done[b]) return true;
+        return _keys[a] < _keys[b] || (!(_keys[b] < _keys[a]) && a < b);
+    }
+
+public:
+    explicit loser_tree(int k) : _tree(max(k, 1)), _keys(k), _done(k, true), _k(k) {}
+
+    // 设置来源 i 的初始元素（没有元素时不调用），全部设置完后调用 build()
+    void set(int i, const T& key) { _keys[i] = key; _done[i] = false; }
+
+    void build() {
+        vector<int> winner(2 * _k);
+        for(int i = 0; i < _k; i++)
+            winner[_k + i] = i;
+        for(int n = _k - 1; n >= 1; n--) {
+            int a = winner[2 * n], b = winner[2 * n + 1];
+            winner[n] = before(a, b) ? a : b;
+            _tree[n] = before(a, b) ? b : a;
+        }
+        _tree[0] = _k == 1 ? 0 : winner[1];
+    }
+
+    bool empty() const { return _done[_tree[0]]; }
+    int top_source() const { return _tree[0]; }
+    const T& top() const { return _keys[_tree[0]]; }
+
+    // 冠军来源读入了下一个元素（has_next 为 false 表示该来源已读完），重新比赛
+    void replace_top(const T& key, bool has_next) {
+        int w = _tree[0];
+        if(has_next) _keys[w] = key;
+        else _done[w] = true;
+        for(int n = (w + _k) / 2; n >= 1; n /= 2) {
+            if(before(_tree[n], w))
+                swap(_tree[n], w);
+        }
+        _tree[0] = w;
+    }
+};
+
+template<typename T>
+class external_sorter
+{
+    static_assert(is_trivially_copyable_v<T>, "external_sort requires trivially copyable records");
+
+    external_sort_options _opts;
+    external_sort_progress& _progress;
+    filesystem::path _temp_dir;
+    string _prefix;
+    size_t _next_id = 0;
+
+    string new_temp_path() {
+        return (_temp_dir / (_prefix + to_string(_next_id++) + ".run")).string();
+    }
+
+    size_t buffer_elems() const { return max<size_t>(_opts.io_buffer_bytes / sizeof(T), 1); }
+
+    // 一次最多归并的路数：内存预算除去输出缓冲后能容纳的输入缓冲个数
+    size_t fan_in() const {
+        return max<size_t>(_opts.memory_bytes / max<size_t>(_opts.io_buffer_bytes, 1), 3) - 1;
+    }
+
+    // 第一阶段：分段读入、排序、写出顺串
+    vector<string> create_runs(const string& input) {
+        vector<string> runs;
+        file_handle in(input, "rb");
+        vector<T> chunk(max<size_t>(_opts.memory_bytes / sizeof(T), 1));
+        while(true) {
+            size_t n = fread(chunk.data(), sizeof(T), chunk.size(), in.get());
+            if(n == 0) {
+                if(ferror(in.get()))
+                    throw runtime_error("read error on " + input);
+                break;
+            }
+            _progress.bytes_read += n * sizeof(T);
+            gsort::sort(chunk.begin(), chunk.begin() + n);
+
+            runs.push_back(new_temp_path());
+            run_writer<T> out(runs.back(), 1, _progress);
+            out.write(chunk.data(), n);
+            _progress.runs_created++;
+        }
+        return runs;
+    }
+
+    // 用败者树把若干顺串归并写入 output
+    void merge(const vector<string>& inputs, const string& output) {
+        int k = static_cast<int>(inputs.size());
+        vector<unique_ptr<run_reader<T>>> readers;
+        loser_tree<T> tree(k);
+        for(int i = 0; i < k; i++) {
+            readers.push_back(make_unique<run_reader<T>>(inputs[i], buffer_elems(), _progress));
+            T value;
+            if(readers[i]->next(value))
+                tree.set(i, value);
+        }
+        tree.build();
+
+        run_writer<T> out(output, buffer_elems(), _progress);
+        T value;
+        while(!tree.empty()) {
+            out.push(tree.top());
+            bool has_next = readers[tree.top_source()]->next(value);
+            tree.replace_top(value, has_next);
+        }
+        out.flush();
+    }
+
+public:
+    external_sorter(const external_sort_options& opts, external_sort_progress& progress)
+        : _opts(opts), _progress(progress)
+    {
+        _temp_dir = opts.temp_dir.empty() ? filesystem::temp_directory_path() : filesystem::path(opts.temp_dir);
+        _prefix = "extsort_" + to_string(random_device{}()) + "_";
+    }
+
+    void sort(const string& input, const string& output) {
+        _progress.restart();
+        _progress.input_bytes = filesystem::file_size(input);
+
+        vector<string> runs = create_runs(input);
+        if(runs.empty()) {
+            file_handle empty_output(output, "wb");
+            _progress.finished = true;
+            return;
+        }
+
+        // 第二阶段：顺串多于归并路数时分组归并，直到剩下的顺串能一次归并到输出文件
+        size_t max_ways = fan_in();
+        while(runs.size() > max_ways) {
+            vector<string> next;
+            for(size_t i = 0; i < runs.size(); i += max_ways) {
+                vector<string> group(runs.begin() + i, runs.begin() + min(i + max_ways, runs.size()));
+                next.push_back(new_temp_path());
+                merge(group, next.back());
+                for(auto& path : group)
+                    filesystem::remove(path);
+            }
+            runs.swap(next);
+            _progress.merge_passes++;
+        }
+        merge(runs, output);
+        for(auto& path : runs)
+            filesystem::remove(path);
+        _progress.merge_passes++;
+        _progress.finished = true;
+    }
+};
+
+/*
+* @brief 外部归并排序
+* @param input/output：输入、输出文件路径（T 的二进制数组）
+*        opts：内存预算、I/O 缓冲区大小、临时目录
+*        progress：可选的进度计数器，可在其他线程中轮询
+*/
+template<typename T>
+void external_sort(const string& input, const string& output,
+                   const external_sort_options& opts = {}, external_sort_progress* progress = nullptr)
+{
+    external_sort_progress local;
+    external_sorter<T> sorter(opts, progress ? *progress : local);
+    sorter.sort(input, output);
+}
+
+// 生成 n 个随机 uint64_t 组成的测试文件
+void write_random_file(const string& path, size_t n, unsigned seed = 42)
+{
+    mt19937_64 rng(seed);
+    external_sort_progress ignored;
+    run_writer<uint64_t> out(path, 1 << 16, ignored);
+    for(size_t i = 0; i < n; i++)
+        out.push(rng());
+    out.flush();
+}
+
+// 校验输出文件有序，且元素个数、元素和与输入一致
+bool verify_sorted_file(const string& input, const string& output)
+{
+    external_sort_progress ignored;
+    run_reader<uint64_t> in(input, 1 << 16, ignored), out(output, 1 << 16, ignored);
+    uint64_t x, sum_in = 0, sum_out = 0, prev = 0;
+    size_t n_in = 0, n_out = 0;
+    while(in.next(x)) { sum_in += x; n_in++; }
+    while(out.next(x)) {
+        if(n_out > 0 && x < prev)
+            return false;
+        prev = x;
+        sum_out += x;
+        n_out++;
+    }
+    return n_in == n_out && sum_in == sum_out;
+}
+
+void test_external_sort()
+{
+    string dir = filesystem::temp_directory_path().string();
+    string input = dir + "/extsort_test_input.bin", output = dir + "/extsort_test_output.bin";
+
+    for(size_t n : {0, 1, 1000, 1000000}) {
+        write_random_file(input, n);
+        // 内存只有 1MB、缓冲 256KB：约 8 个顺串，每次最多 3 路归并，会触发多趟归并
+        external_sort_options opts;
+        opts.memory_bytes = 1 << 20;
+        opts.io_buffer_bytes = 256 << 10;
+        external_sort_progress progress;
+        external_sort<uint64_t>(input, output, opts, &progress);
+        if(!verify_sorted_file(input, output)) {
+            cout << "external_sort failed at n = " << n << endl;
+            return;
+        }
+    }
+    filesystem::remove(input);
+    filesystem::remove(output);
+    cout << "External sort test passed." << endl;
+}
+
+// 排序一个较大的文件，另起线程每秒打印一次进度和吞吐量
+void bench_external_sort(size_t n = 100000000, size_t memory_mb = 64)
+{
+    string dir = filesystem::temp_directory_path().string();
+    string input = dir + "/extsort_bench_input.bin", output = dir + "/extsort_bench_output.bin";
+    write_random_file(input, n);
+
+    external_sort_options opts;
+    opts.memory_bytes = memory_mb << 20;
+    external_sort_progress progress;
+
+    thread monitor([&progress]{
+        while(!progress.finished) {
+            this_thread::sleep_for(chrono::seconds(1));
+            cout << "runs: " << progress.runs_created
+                 << "  merge passes: " << progress.merge_passes
+                 << "  read: " << (progress.bytes_read >> 20) << " MB"
+                 << "  written: " << (progress.bytes_written >> 20) << " MB"
+                 << "  throughput: " << progress.throughput_mb_s() << " MB/s" << endl;
+        }
+    });
+    external_sort<uint64_t>(input, output, opts, &progress);
+    monitor.join();
+
+    cout << "sorted " << (progress.input_bytes >> 20) << " MB in " << progress.elapsed_s() << " s, "
+         << progress.runs_created << " runs, " << progress.merge_passes << " merge pass(es)" << endl;
+    filesystem::remove(input);
+    filesystem::remove(output);
+}
+
+int main()
+{
+    test_external_sort();
+    // bench_external_sort();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cassert>
+#include "generic_sort.hpp"
+using namespace std;
+
+// g++ .\generic_sort.cpp -std=c++17 -O2
+
+struct Order {
+    uint64_t id;
+    double price;
+    int qty;
+};
+
+template<typename F>
+double time_ms(F&& f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+// 编译期分发：哪些类型/比较器组合会走无分支内核
+void test_dispatch()
+{
+    static_assert(gsort::detail::use_branchless_v<int, less<>>);
+    static_assert(gsort::detail::use_branchless_v<uint64_t, less<uint64_t>>);
+    static_assert(gsort::detail::use_branchless_v<double, greater<>>);
+    static_assert(!gsort::detail::use_branchless_v<string, less<>>);
+    static_assert(!gsort::detail::use_branchless_v<Order, less<>>);
+    cout << "Dispatch test passed.\n";
+}
+
+void test_basic_types()
+{
+    mt19937_64 rng(42);
+
+    vector<uint64_t> ids(100000);
+    for(auto& x : ids) x = rng() % 1000; // 大量重复
+    vector<uint64_t> expect_ids = ids;
+    std::sort(expect_ids.begin(), expect_ids.end());
+    gsort::sort(ids.begin(), ids.end());
+    assert(ids == expect_ids);
+
+    vector<double> prices(100000);
+    for(auto& x : prices) x = static_cast<double>(rng()) / 1e6 - 1e12;
+    vector<double> expect_prices = prices;
+    std::sort(expect_prices.begin(), expect_prices.end(), greater<>());
+    gsort::sort(prices.begin(), prices.end(), greater<>());
+    assert(prices == expect_prices);
+
+    // 原生数组同样可用（指针即随机访问迭代器）
+    int arr[] = {2, 1, 5, 4, 3};
+    gsort::sort(arr, arr + 5);
+    for(int x : arr) cout << x << " ";
+    cout << "\n";
+
+    cout << "Basic types test passed.\n";
+}
+
+void test_struct_by_key()
+{
+    mt19937_64 rng(7);
+    vector<Order> orders(50000);
+    for(auto& o : orders) o = {rng(), static_cast<double>(rng() % 10000) / 100, static_cast<int>(rng() % 100)};
+
+    gsort::sort_by_key(orders.begin(), orders.end(), [](const Order& o){ return o.price; });
+    assert(is_sorted(orders.begin(), orders.end(), [](const Order& a, const Order& b){
+        return a.price < b.price;
+    }));
+
+    gsort::sort(orders.begin(), orders.end(), [](const Order& a, const Order& b){
+        return a.id < b.id;
+    });
+    assert(is_sorted(orders.begin(), orders.end(), [](const Order& a, const Order& b){
+        return a.id < b.id;
+    }));
+    cout << "Struct by key test passed.\n";
+}
+
+// 只能移动的类型能通过编译并正确排序，说明排序过程中没有发生拷贝
+void test_move_only()
+{
+    vector<unique_ptr<int>> v;
+    for(int i = 0; i < 1000; i++)
+        v.push_back(make_unique<int>((i * 7919) % 1000));
+    gsort::sort(v.begin(), v.end(), [](const unique_ptr<int>& a, const unique_ptr<int>& b){
+        return *a < *b;
+    });
+    for(int i = 0; i < 1000; i++)
+        assert(*v[i] == i);
+
+    vector<string> words = {"pear", "apple", "fig", "apple", "kiwi", "banana"};
+    gsort::sort(words.begin(), words.end());
+    assert(is_sorted(words.begin(), words.end()));
+    cout << "Move-only test passed.\n";
+}
+
+// 三路划分的边界：全部相等、只有两种值等情况下，返回的区间正确，也不会越过 first
+void test_partition3_edges()
+{
+    vector<vector<string>> cases = {
+        {"b", "b", "b", "b"},
+        {"a", "b", "a", "b", "a"},
+        {"c", "a", "b", "c", "a", "b", "c"},
+        {"x", "y"},
+    };
+    for(auto& v : cases) {
+        auto [lt, gt] = gsort::detail::partition3(v.begin(), v.end(), less<>());
+        assert(lt < gt);
+        const string pivot = *lt;
+        for(auto it = v.begin(); it != lt; ++it) assert(*it < pivot);
+        for(auto it = lt; it != gt; ++it) assert(*it == pivot);
+        for(auto it = gt; it != v.end(); ++it) assert(pivot < *it);
+    }
+    cout << "Partition3 edge test passed.\n";
+}
+
+void bench_generic_sort()
+{
+    const size_t n = 10000000;
+    mt19937_64 rng(42);
+
+    vector<uint64_t> ids(n);
+    for(auto& x : ids) x = rng();
+    vector<uint64_t> a = ids, b = ids;
+    cout << "uint64_t  std::sort: " << time_ms([&]{ std::sort(a.begin(), a.end()); }) << " ms"
+         << "  gsort::sort: " << time_ms([&]{ gsort::sort(b.begin(), b.end()); }) << " ms\n";
+
+    vector<double> prices(n);
+    for(auto& x : prices) x = static_cast<double>(rng()) / 1e6;
+    vector<double> c = prices, d = prices;
+    cout << "double    std::sort: " << time_ms([&]{ std::sort(c.begin(), c.end()); }) << " ms"
+         << "  gsort::sort: " << time_ms([&]{ gsort::sort(d.begin(), d.end()); }) << " ms\n";
+
+    vector<Order> orders(n);
+    for(auto& o : orders) o = {rng(), static_cast<double>(rng() % 10000) / 100, 0};
+    vector<Order> e = orders, f = orders;
+    auto by_price = [](const Order& x, const Order& y){ return x.price < y.price; };
+    cout << "Order     std::sort: " << time_ms([&]{ std::sort(e.begin(), e.end(), by_price); }) << " ms"
+         << "  gsort::sort: " << time_ms([&]{ gsort::sort(f.begin(), f.end(), by_price); }) << " ms\n";
+}
+
+int main()
+{
+    test_dispatch();
+    test_basic_types();
+    test_struct_by_key();
+    test_move_only();
+    test_partition3_edges();
+    // bench_generic_sort();
+
+    return 0;
+}
\ No newline at end of file
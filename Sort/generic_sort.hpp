@@ -0,0 +1,316 @@
+#ifndef GENERIC_SORT_HPP
+#define GENERIC_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+/*
+    泛型排序（header-only），quick_sort.cpp 中 intro_sort 的模板化版本，另外提供基于同一划分过程的 nth_element / partial_sort：
+        template<RandomIt, Compare> 适用于任意随机访问迭代器、比较器和元素类型；
+        仍然是原地排序，不分配任何内存；
+        元素一律通过 std::move / std::iter_swap 移动，不做拷贝（可以排序 unique_ptr 这类只能移动的类型）。
+    编译期分发（见 TemplateMetaprogramming/type_traits.cpp）：
+        算术类型 + 标准比较器（std::less / std::greater）：使用无分支的 Lomuto 划分内核；
+        其他类型：使用三路划分（Bentley-McIlroy），比较次数少、重复元素友好。
+    g++ .\generic_sort.cpp -std=c++17 -O2
+*/
+namespace gsort {
+
+namespace detail {
+
+constexpr std::ptrdiff_t INSERTION_SORT_THRESHOLD = 16;
+constexpr std::ptrdiff_t NINTHER_THRESHOLD = 128;
+
+// 比较器是否为标准库的 less/greater（它们对算术类型是全序，可以安全地转成 0/1 参与运算）
+template<typename T, typename Compare>
+struct is_standard_compare : std::false_type {};
+template<typename T>
+struct is_standard_compare<T, std::less<T>> : std::true_type {};
+template<typename T>
+struct is_standard_compare<T, std::less<>> : std::true_type {};
+template<typename T>
+struct is_standard_compare<T, std::greater<T>> : std::true_type {};
+template<typename T>
+struct is_standard_compare<T, std::greater<>> : std::true_type {};
+
+// 是否走无分支内核：元素是算术类型，且比较器是标准比较器
+template<typename T, typename Compare>
+inline constexpr bool use_branchless_v =
+    std::is_arithmetic_v<T> && is_standard_compare<T, Compare>::value;
+
+template<typename RandomIt, typename Compare>
+void insertion_sort(RandomIt first, RandomIt last, Compare comp)
+{
+    if(first == last)
+        return;
+    for(RandomIt i = first + 1; i != last; ++i)
+    {
+        auto temp = std::move(*i);
+        RandomIt j = i;
+        for(; j != first && comp(temp, *(j - 1)); --j)
+            *j = std::move(*(j - 1));
+        *j = std::move(temp);
+    }
+}
+
+// 堆排序兜底：标准库的堆算法同样是原地、基于移动的
+template<typename RandomIt, typename Compare>
+void heap_sort(RandomIt first, RandomIt last, Compare comp)
+{
+    std::make_heap(first, last, comp);
+    std::sort_heap(first, last, comp);
+}
+
+template<typename RandomIt, typename Compare>
+RandomIt median_of_three(RandomIt a, RandomIt b, RandomIt c, Compare comp)
+{
+    if(comp(*a, *b)) {
+        if(comp(*b, *c)) return b;
+        return comp(*a, *c) ? c : a;
+    }
+    if(comp(*a, *c)) return a;
+    return comp(*b, *c) ? c : b;
+}
+
+// 小区间三数取中，大区间九数取中
+template<typename RandomIt, typename Compare>
+RandomIt choose_pivot(RandomIt first, RandomIt last, Compare comp)
+{
+    auto n = last - first;
+    RandomIt m = first + n / 2, back = last - 1;
+    if(n > NINTHER_THRESHOLD)
+    {
+        auto s = n / 8;
+        RandomIt a = median_of_three(first, first + s, first + 2 * s, comp);
+        RandomIt b = median_of_three(m - s, m, m + s, comp);
+        RandomIt c = median_of_three(back - 2 * s, back - s, back, comp);
+        return median_of_three(a, b, c, comp);
+    }
+    return median_of_three(first, m, back, comp);
+}
+
+/*
+    三路划分（Bentley-McIlroy），基准放在 first，划分后
+        [first, lt) < pivot、[lt, gt) == pivot、[gt, last) > pivot
+    基准始终留在区间内参与比较，不需要拷贝一份基准值。
+*/
+template<typename RandomIt, typename Compare>
+std::pair<RandomIt, RandomIt> partition3(RandomIt first, RandomIt last, Compare comp)
+{
+    std::iter_swap(first, choose_pivot(first, last, comp));
+    RandomIt back = last - 1;
+    RandomIt i = first, j = last, p = first, q = last;
+    while(true)
+    {
+        while(comp(*++i, *first))
+            if(i == back) break;
+        while(comp(*first, *--j))
+            if(j == first) break;
+        if(i == j && !comp(*i, *first) && !comp(*first, *i))
+            std::iter_swap(++p, i);
+        if(i >= j)
+            break;
+
+        std::iter_swap(i, j);
+        if(!comp(*i, *first) && !comp(*first, *i)) std::iter_swap(++p, i);
+        if(!comp(*j, *first) && !comp(*first, *j)) std::iter_swap(--q, j);
+    }
+
+    // 把两端与基准相等的元素换回中间（基准本身在 first，也在 [first, p] 中）
+    // 用偏移量计算位置，j == first 时也不会构造出 first 之前的迭代器
+    auto left = p - first + 1, right = last - q;
+    for(decltype(left) d = 0; d < left; ++d)
+        std::iter_swap(first + d, j - d);
+    for(decltype(right) d = 0; d < right; ++d)
+        std::iter_swap(back - d, j + 1 + d);
+    return {j + 1 - left, j + 1 + right};
+}
+
+// 无分支 Lomuto 划分：满足 pred 的元素移到前面，返回分界位置
+template<typename RandomIt, typename Pred>
+RandomIt partition_branchless(RandomIt first, RandomIt last, Pred pred)
+{
+    RandomIt i = first;
+    for(RandomIt j = first; j != last; ++j)
+    {
+        auto x = *j;
+        *j = *i;
+        *i = x;
+        i += pred(x);
+    }
+    return i;
+}
+
+/*
+    一次划分，返回 (lt, gt)：[first, lt) < pivot、[gt, last) 不小于 pivot，[lt, gt) 中全部等于 pivot。
+        三路划分：[gt, last) > pivot；
+        无分支内核：只做一次二路划分，lt == gt；若基准恰好是区间最值（左侧为空），
+        再划分一次把等于基准的元素整体剔除，避免重复元素导致每次只前进一个元素。
+*/
+template<typename RandomIt, typename Compare>
+std::pair<RandomIt, RandomIt> partition_step(RandomIt first, RandomIt last, Compare comp)
+{
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+
+    if constexpr (use_branchless_v<T, Compare>) {
+        T pivot = *choose_pivot(first, last, comp);
+        RandomIt lt = partition_branchless(first, last, [&](T x){ return comp(x, pivot); });
+        if(lt != first)
+            return {lt, lt};
+        return {first, partition_branchless(first, last, [&](T x){ return !comp(pivot, x); })};
+    } else {
+        return partition3(first, last, comp);
+    }
+}
+
+// 堆选择：把 [first, last) 中最小的 middle - first 个元素放到 [first, middle)，以大顶堆形式存放
+template<typename RandomIt, typename Compare>
+void heap_select(RandomIt first, RandomIt middle, RandomIt last, Compare comp)
+{
+    std::make_heap(first, middle, comp);
+    for(RandomIt i = middle; i != last; ++i)
+    {
+        if(comp(*i, *first)) {
+            std::pop_heap(first, middle, comp);
+            std::iter_swap(middle - 1, i);
+            std::push_heap(first, middle, comp);
+        }
+    }
+}
+
+template<typename RandomIt, typename Compare>
+void intro_sort_loop(RandomIt first, RandomIt last, int depth_limit, Compare comp)
+{
+    while(last - first > INSERTION_SORT_THRESHOLD)
+    {
+        if(depth_limit == 0) {
+            heap_sort(first, last, comp);
+            return;
+        }
+        depth_limit--;
+
+        auto [lt, gt] = partition_step(first, last, comp);
+        // 只对较小的一侧递归，栈深度 O(logn)
+        if(lt - first < last - gt) {
+            intro_sort_loop(first, lt, depth_limit, comp);
+            first = gt;
+        } else {
+            intro_sort_loop(gt, last, depth_limit, comp);
+            last = lt;
+        }
+    }
+    insertion_sort(first, last, comp);
+}
+
+// 快速选择：每次划分后只进入 nth 所在的一侧，期望 O(n)
+template<typename RandomIt, typename Compare>
+void intro_select_loop(RandomIt first, RandomIt nth, RandomIt last, int depth_limit, Compare comp)
+{
+    while(last - first > INSERTION_SORT_THRESHOLD)
+    {
+        // 划分层数超过上限时改用堆选择，最坏 O(nlogn)
+        if(depth_limit == 0) {
+            heap_select(first, nth + 1, last, comp);
+            std::iter_swap(first, nth); // 堆顶即前 nth - first + 1 小元素中的最大者
+            return;
+        }
+        depth_limit--;
+
+        auto [lt, gt] = partition_step(first, last, comp);
+        if(nth < lt)
+            last = lt;
+        else if(nth >= gt)
+            first = gt;
+        else
+            return; // nth 落在等于基准的区间内，已经就位
+    }
+    insertion_sort(first, last, comp);
+}
+
+inline int depth_limit_for(std::ptrdiff_t n)
+{
+    int depth_limit = 0;
+    for(; n > 1; n >>= 1)
+        depth_limit += 2;
+    return depth_limit;
+}
+
+} // namespace detail
+
+/*
+* @brief 泛型内省排序
+* @template param
+*   RandomIt：随机访问迭代器
+*   Compare：满足严格弱序的比较器，默认 std::less<>
+* @param first/last：排序范围 [first, last)
+*/
+template<typename RandomIt, typename Compare>
+void sort(RandomIt first, RandomIt last, Compare comp)
+{
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                      typename std::iterator_traits<RandomIt>::iterator_category>,
+                  "gsort::sort requires random access iterators");
+    if(last - first < 2)
+        return;
+    detail::intro_sort_loop(first, last, detail::depth_limit_for(last - first), comp);
+}
+
+template<typename RandomIt>
+void sort(RandomIt first, RandomIt last)
+{
+    gsort::sort(first, last, std::less<>());
+}
+
+// 按键排序：key(x) 返回用于比较的键，例如按结构体的某个字段排序
+template<typename RandomIt, typename KeyFn>
+void sort_by_key(RandomIt first, RandomIt last, KeyFn key)
+{
+    gsort::sort(first, last, [&key](const auto& a, const auto& b){
+        return key(a) < key(b);
+    });
+}
+
+/*
+* @brief 选择第 n 小的元素（与 std::nth_element 语义相同）
+*   完成后 *nth 就是完全排序时该位置的元素，[first, nth) 中的元素都不大于它，(nth, last) 中的都不小于它
+*/
+template<typename RandomIt, typename Compare>
+void nth_element(RandomIt first, RandomIt nth, RandomIt last, Compare comp)
+{
+    if(last - first < 2 || nth == last)
+        return;
+    detail::intro_select_loop(first, nth, last, detail::depth_limit_for(last - first), comp);
+}
+
+template<typename RandomIt>
+void nth_element(RandomIt first, RandomIt nth, RandomIt last)
+{
+    gsort::nth_element(first, nth, last, std::less<>());
+}
+
+/*
+* @brief 部分排序（top-k）：把最小的 middle - first 个元素按顺序放到 [first, middle)，其余元素顺序不定
+*   先用快速选择找出前 k 个元素，再只排序这 k 个，复杂度 O(n + klogk)
+*/
+template<typename RandomIt, typename Compare>
+void partial_sort(RandomIt first, RandomIt middle, RandomIt last, Compare comp)
+{
+    if(middle == first)
+        return;
+    gsort::nth_element(first, middle - 1, last, comp);
+    gsort::sort(first, middle - 1, comp);
+}
+
+template<typename RandomIt>
+void partial_sort(RandomIt first, RandomIt middle, RandomIt last)
+{
+    gsort::partial_sort(first, middle, last, std::less<>());
+}
+
+} // namespace gsort
+
+#endif
\ No newline at end of file
@@ -1,6 +1,26 @@
 #include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <climits>
+#include <cstdint>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define QS_HAVE_AVX2_KERNEL 1
+#endif
 using namespace std;
 
+// g++ .\quick_sort.cpp -std=c++17 -O2 -pthread
+
 void quick_sort1(int arr[], int l, int r)
 {
     if(l < r)
@@ -34,27 +54,772 @@ void quick_sort1(int arr[], int l, int r)
     }
 }
 
+// 以中间元素为基准的挖坑法划分，返回基准最终所在位置
+int partition2(int arr[], int l, int r)
+{
+    swap(arr[l], arr[(l + r) / 2]);
+    int i = l, j = r, temp = arr[l];
+    while(i < j)
+    {
+        while(i < j && arr[j] >= temp)
+            j--;
+        if(i < j)
+            arr[i++] = arr[j];
+
+        while(i < j && arr[i] < temp)
+            i++;
+        if(i < j)
+            arr[j--] = arr[i];
+    }
+    arr[i] = temp;
+    return i;
+}
+
 void quick_sort2(int arr[], int l, int r)
 {
     if(l < r)
     {
-        swap(arr[l], arr[(l + r) / 2]);
-        int i = l, j = r, temp = arr[l];
-        while(i < j)
+        int i = partition2(arr, l, r);
+        quick_sort2(arr, l, i - 1);
+        quick_sort2(arr, i + 1, r);
+    }
+}
+
+constexpr int INSERTION_SORT_THRESHOLD = 16; // 小区间直接插入排序
+constexpr int NINTHER_THRESHOLD = 128;       // 区间大于该长度时用九数取中（ninther）选基准
+
+void insertion_sort(int arr[], int l, int r)
+{
+    for(int i = l + 1; i <= r; i++)
+    {
+        int temp = arr[i], j = i - 1;
+        while(j >= l && arr[j] > temp)
         {
-            while(i < j && arr[j] >= temp)
-                j--;
-            if(i < j)
-                arr[i++] = arr[j];
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = temp;
+    }
+}
 
-            while(i < j && arr[i] < temp)
-                i++;
-            if(i < j)
-                arr[j--] = arr[i];
+// 大顶堆下沉：堆存放在 arr[l, l + n) 中，root 为相对 l 的下标
+void sift_down(int arr[], int l, int root, int n)
+{
+    int temp = arr[l + root];
+    int child;
+    while((child = 2 * root + 1) < n)
+    {
+        if(child + 1 < n && arr[l + child] < arr[l + child + 1])
+            child++;
+        if(arr[l + child] <= temp)
+            break;
+        arr[l + root] = arr[l + child];
+        root = child;
+    }
+    arr[l + root] = temp;
+}
+
+void heap_sort(int arr[], int l, int r)
+{
+    int n = r - l + 1;
+    for(int i = n / 2 - 1; i >= 0; i--)
+        sift_down(arr, l, i, n);
+    for(int i = n - 1; i > 0; i--)
+    {
+        swap(arr[l], arr[l + i]);
+        sift_down(arr, l, 0, i);
+    }
+}
+
+// 三数取中：返回 a、b、c 三个位置中值居中的那个下标
+int median_of_three(int arr[], int a, int b, int c)
+{
+    if(arr[a] < arr[b]) {
+        if(arr[b] < arr[c]) return b;
+        return arr[a] < arr[c] ? c : a;
+    }
+    if(arr[a] < arr[c]) return a;
+    return arr[b] < arr[c] ? c : b;
+}
+
+// 小区间三数取中，大区间九数取中（Tukey's ninther），降低有序/构造输入下选到极值的概率
+int choose_pivot(int arr[], int l, int r)
+{
+    int n = r - l + 1, m = l + n / 2;
+    if(n > NINTHER_THRESHOLD)
+    {
+        int s = n / 8;
+        int a = median_of_three(arr, l, l + s, l + 2 * s);
+        int b = median_of_three(arr, m - s, m, m + s);
+        int c = median_of_three(arr, r - 2 * s, r - s, r);
+        return median_of_three(arr, a, b, c);
+    }
+    return median_of_three(arr, l, m, r);
+}
+
+/*
+    三路划分（Bentley-McIlroy）：划分后
+        [l, lt)   < pivot
+        [lt, gt]  == pivot
+        (gt, r]   > pivot
+    扫描时把与基准相等的元素先交换到区间两端，扫描结束后再换回中间。
+    相等元素一次就位，不再参与后续递归，大量重复元素（甚至全部相等）时退化为 O(n)；
+    而互不相同的元素只在左右指针都停下时交换一次，交换次数与普通双路划分相同。
+*/
+void partition3(int arr[], int l, int r, int& lt, int& gt)
+{
+    swap(arr[l], arr[choose_pivot(arr, l, r)]);
+    int pivot = arr[l];
+    int i = l, j = r + 1, p = l, q = r + 1;
+    while(true)
+    {
+        while(arr[++i] < pivot)
+            if(i == r) break;
+        while(pivot < arr[--j])
+            if(j == l) break;
+        if(i == j && arr[i] == pivot)
+            swap(arr[++p], arr[i]);
+        if(i >= j)
+            break;
+
+        swap(arr[i], arr[j]);
+        if(arr[i] == pivot) swap(arr[++p], arr[i]);
+        if(arr[j] == pivot) swap(arr[--q], arr[j]);
+    }
+
+    // 把两端与基准相等的元素换回中间
+    i = j + 1;
+    for(int k = l; k <= p; k++)
+        swap(arr[k], arr[j--]);
+    for(int k = r; k >= q; k--)
+        swap(arr[k], arr[i++]);
+    lt = j + 1;
+    gt = i - 1;
+}
+
+void intro_sort_loop(int arr[], int l, int r, int depth_limit)
+{
+    while(r - l + 1 > INSERTION_SORT_THRESHOLD)
+    {
+        // 划分层数超过上限说明基准一直选得很差，改用堆排序保证 O(nlogn)
+        if(depth_limit == 0) {
+            heap_sort(arr, l, r);
+            return;
         }
-        arr[i] = temp;
-        quick_sort2(arr, l, i - 1);
-        quick_sort2(arr, i + 1, r);
+        depth_limit--;
+
+        int lt, gt;
+        partition3(arr, l, r, lt, gt);
+        // 只对较小的一侧递归，较大的一侧留在循环中处理，递归深度不超过 log2(n)
+        if(lt - l < r - gt) {
+            intro_sort_loop(arr, l, lt - 1, depth_limit);
+            l = gt + 1;
+        } else {
+            intro_sort_loop(arr, gt + 1, r, depth_limit);
+            r = lt - 1;
+        }
+    }
+    insertion_sort(arr, l, r);
+}
+
+/*
+* @brief 内省排序（introsort），quick_sort2 的加固版本，作为生产环境的排序入口
+*   1. 九数取中/三数取中选基准
+*   2. 三路划分处理重复元素
+*   3. 只递归较小的一侧，栈深度 O(logn)
+*   4. 划分深度超过 2*log2(n) 时切换为堆排序，最坏 O(nlogn)
+*   5. 长度不超过 INSERTION_SORT_THRESHOLD 的区间用插入排序
+* @param arr/l/r：与 quick_sort2 相同，排序闭区间 [l, r]
+*/
+void intro_sort(int arr[], int l, int r)
+{
+    if(l >= r)
+        return;
+    int depth_limit = 0;
+    for(int n = r - l + 1; n > 1; n >>= 1)
+        depth_limit += 2;
+    intro_sort_loop(arr, l, r, depth_limit);
+}
+
+/*
+    向量化快速排序的划分内核：
+        把 arr[0, n) 划分为 [0, k) < pivot、[k, n) >= pivot 两部分，返回 k。
+        标量版本为无分支的 Lomuto 划分；AVX2 版本一次比较 8 个 int，
+        用“比较掩码 -> 置换表”把左侧元素压缩到向量低位、右侧元素压缩到高位后整体写出，循环中没有数据相关的分支。
+    运行时检测 CPU 是否支持 AVX2 来选择内核，不需要以 -mavx2 编译整个文件。
+*/
+using partition_kernel = int (*)(int* arr, int n, int pivot);
+
+int partition_scalar(int* arr, int n, int pivot)
+{
+    int i = 0;
+    for(int j = 0; j < n; j++)
+    {
+        int x = arr[j];
+        arr[j] = arr[i];
+        arr[i] = x;
+        i += (x < pivot); // 小于基准时左侧边界右移，否则这次交换相当于原地不动
+    }
+    return i;
+}
+
+#ifdef QS_HAVE_AVX2_KERNEL
+// 置换表：掩码第 k 位为 1 表示第 k 个元素属于左侧，表项把左侧元素依次排到低位、右侧元素排到高位
+struct compress_table {
+    alignas(32) int32_t idx[256][8];
+    compress_table() {
+        for(int mask = 0; mask < 256; mask++) {
+            int pos = 0;
+            for(int k = 0; k < 8; k++)
+                if(mask & (1 << k)) idx[mask][pos++] = k;
+            for(int k = 0; k < 8; k++)
+                if(!(mask & (1 << k))) idx[mask][pos++] = k;
+        }
+    }
+};
+const compress_table COMPRESS_TABLE;
+
+__attribute__((target("avx2,popcnt")))
+inline void partition_vec8(__m256i v, __m256i pivot_vec, int* arr, int& store_left, int& store_right)
+{
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot_vec, v)));
+    int left_count = __builtin_popcount(mask);
+    __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPRESS_TABLE.idx[mask]));
+    v = _mm256_permutevar8x32_epi32(v, perm);
+    // 整个向量写两次：左端写出的低位是左侧元素，右端写出的高位是右侧元素，多写的部分落在空闲区，之后会被覆盖
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(arr + store_left), v);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(arr + store_right - 8), v);
+    store_left += left_count;
+    store_right -= 8 - left_count;
+}
+
+/*
+    原地向量化划分：
+        先把首尾各 8 个元素读进寄存器，两端就各空出 8 个位置；
+        每次从空闲位置较少的一端再读 8 个元素，划分后写回两端的空闲区，保证两端写出时都至少有 8 个空位；
+        最后不足 8 个的剩余元素和开始保存的两个向量一起写入中间恰好空出的位置。
+*/
+__attribute__((target("avx2,popcnt")))
+int partition_avx2(int* arr, int n, int pivot)
+{
+    // 区间太短时收尾的标量部分占比过高，直接用标量内核更快（至少需要 16 个元素）
+    if(n < 64)
+        return partition_scalar(arr, n, pivot);
+
+    __m256i pivot_vec = _mm256_set1_epi32(pivot);
+    __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr));
+    __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr + n - 8));
+
+    int store_left = 0, store_right = n;
+    int read_left = 8, read_right = n - 8;
+    while(read_right - read_left >= 8)
+    {
+        __m256i v;
+        if(read_left - store_left <= store_right - read_right) {
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr + read_left));
+            read_left += 8;
+        } else {
+            read_right -= 8;
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr + read_right));
+        }
+        partition_vec8(v, pivot_vec, arr, store_left, store_right);
+    }
+
+    // 剩余元素先复制出来，[store_left, store_right) 就全部是空位，正好容纳剩余元素和首尾两个向量
+    int rest[24];
+    int rest_count = read_right - read_left;
+    for(int k = 0; k < rest_count; k++)
+        rest[k] = arr[read_left + k];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rest + rest_count), first);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rest + rest_count + 8), last);
+    for(int k = 0; k < rest_count + 16; k++)
+    {
+        int x = rest[k];
+        bool left = x < pivot;
+        arr[left ? store_left : store_right - 1] = x;
+        store_left += left;
+        store_right -= !left;
+    }
+    return store_left;
+}
+#endif
+
+partition_kernel select_partition_kernel()
+{
+#ifdef QS_HAVE_AVX2_KERNEL
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        return partition_avx2;
+#endif
+    return partition_scalar;
+}
+
+const partition_kernel PARTITION_KERNEL = select_partition_kernel();
+
+void simd_quick_sort_loop(int arr[], int l, int r, int depth_limit, partition_kernel kernel)
+{
+    while(r - l + 1 > INSERTION_SORT_THRESHOLD)
+    {
+        if(depth_limit == 0) {
+            heap_sort(arr, l, r);
+            return;
+        }
+        depth_limit--;
+
+        int pivot = arr[choose_pivot(arr, l, r)];
+        int k = kernel(arr + l, r - l + 1, pivot);
+        if(k == 0) {
+            /*
+                基准是区间最小值：再以 pivot + 1 划分一次，把等于基准的元素整体剔除，
+                避免大量重复元素时每次只前进一个元素
+            */
+            if(pivot == INT_MAX)
+                return; // 区间内全部等于 INT_MAX
+            l += kernel(arr + l, r - l + 1, pivot + 1);
+            continue;
+        }
+
+        int m = l + k; // [l, m) < pivot, [m, r] >= pivot
+        if(m - l < r - m + 1) {
+            simd_quick_sort_loop(arr, l, m - 1, depth_limit, kernel);
+            l = m;
+        } else {
+            simd_quick_sort_loop(arr, m, r, depth_limit, kernel);
+            r = m - 1;
+        }
+    }
+    insertion_sort(arr, l, r);
+}
+
+/*
+* @brief 使用向量化划分内核的快速排序，内核在程序启动时按CPU特性选择
+* @param arr/l/r：与 quick_sort2 相同，排序闭区间 [l, r]
+*        kernel：划分内核，默认使用运行时检测选出的内核
+*/
+void simd_quick_sort(int arr[], int l, int r, partition_kernel kernel = PARTITION_KERNEL)
+{
+    if(l >= r)
+        return;
+    int depth_limit = 0;
+    for(int n = r - l + 1; n > 1; n >>= 1)
+        depth_limit += 2;
+    simd_quick_sort_loop(arr, l, r, depth_limit, kernel);
+}
+
+/*
+    工作窃取（work-stealing）任务池：
+        每个工作线程拥有自己的双端队列，新任务压入自己队列的尾部，自己也从尾部取（LIFO，缓存友好）；
+        自己的队列空了，就随机挑一个其他线程，从它队列的头部“偷”任务（FIFO，偷到的通常是较大的区间）。
+    调用 wait_idle() 的线程占用 0 号队列，也参与执行任务，直到所有任务完成。
+*/
+class work_stealing_pool
+{
+public:
+    using task = function<void()>;
+
+    explicit work_stealing_pool(unsigned num_threads)
+    {
+        if(num_threads == 0)
+            num_threads = 1;
+        for(unsigned i = 0; i < num_threads; i++)
+            queues.emplace_back(make_unique<worker_queue>());
+        // 0 号队列留给调用 wait_idle() 的线程，其余每个队列对应一个后台线程
+        for(unsigned i = 1; i < num_threads; i++)
+            threads.emplace_back(&work_stealing_pool::worker_loop, this, i);
+    }
+
+    ~work_stealing_pool()
+    {
+        {
+            lock_guard<mutex> lock(idle_mutex);
+            done = true;
+        }
+        idle_cond.notify_all();
+        for(auto& t : threads)
+            t.join();
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    // 提交任务：池内线程压入自己的队列，外部线程压入 0 号队列
+    void submit(task t)
+    {
+        int index = (tls_pool == this) ? tls_index : 0;
+        // 先计数再入队，保证任务执行完之前 pending 不会归零
+        if(pending.fetch_add(1) == 0) {
+            lock_guard<mutex> lock(idle_mutex); // 加锁后再通知，避免丢失唤醒
+            idle_cond.notify_all();
+        }
+        lock_guard<mutex> lock(queues[index]->mtx);
+        queues[index]->tasks.push_back(move(t));
+    }
+
+    // 调用线程作为 0 号工作者参与执行，直到所有已提交的任务（包括任务派生的子任务）完成
+    void wait_idle()
+    {
+        tls_pool = this;
+        tls_index = 0;
+        task t;
+        while(pending.load() != 0) {
+            if(pop_local(0, t) || steal(0, t))
+                run(t);
+            else
+                this_thread::yield();
+        }
+        tls_pool = nullptr;
+    }
+
+    size_t size() const { return queues.size(); }
+
+private:
+    // 每个队列独占缓存行，避免相邻队列的锁互相造成伪共享
+    struct alignas(64) worker_queue {
+        mutex mtx;
+        deque<task> tasks;
+    };
+
+    vector<unique_ptr<worker_queue>> queues;
+    vector<thread> threads;
+    atomic<size_t> pending{0}; // 已提交但尚未执行完的任务数
+    mutex idle_mutex;
+    condition_variable idle_cond;
+    bool done = false;
+
+    static thread_local work_stealing_pool* tls_pool;
+    static thread_local int tls_index;
+
+    bool pop_local(int index, task& t)
+    {
+        lock_guard<mutex> lock(queues[index]->mtx);
+        if(queues[index]->tasks.empty())
+            return false;
+        t = move(queues[index]->tasks.back());
+        queues[index]->tasks.pop_back();
+        return true;
+    }
+
+    // 从随机选择的受害者开始，依次尝试窃取其他队列头部的任务
+    bool steal(int index, task& t)
+    {
+        static thread_local minstd_rand rng(random_device{}());
+        size_t n = queues.size();
+        size_t start = rng() % n;
+        for(size_t k = 0; k < n; k++) {
+            size_t victim = (start + k) % n;
+            if(victim == static_cast<size_t>(index))
+                continue;
+            lock_guard<mutex> lock(queues[victim]->mtx);
+            if(!queues[victim]->tasks.empty()) {
+                t = move(queues[victim]->tasks.front());
+                queues[victim]->tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(task& t)
+    {
+        t();
+        t = nullptr;
+        pending.fetch_sub(1);
+    }
+
+    void worker_loop(int index)
+    {
+        tls_pool = this;
+        tls_index = index;
+        task t;
+        while(true) {
+            if(pop_local(index, t) || steal(index, t)) {
+                run(t);
+                continue;
+            }
+            if(pending.load() != 0) {
+                this_thread::yield(); // 还有任务在执行，可能很快派生出新任务，短暂让出即可
+                continue;
+            }
+            // 池空闲时挂起，避免空转占用CPU
+            unique_lock<mutex> lock(idle_mutex);
+            idle_cond.wait(lock, [this]{
+                return done || pending.load() != 0;
+            });
+            if(done)
+                return;
+        }
+    }
+};
+
+thread_local work_stealing_pool* work_stealing_pool::tls_pool = nullptr;
+thread_local int work_stealing_pool::tls_index = 0;
+
+constexpr int PARALLEL_CUTOFF = 1 << 15; // 区间小于该长度时退化为串行 quick_sort2
+
+// 划分一次后把较大的一侧作为新任务交给任务池（便于被窃取），当前任务继续处理较小的一侧
+void parallel_quick_sort_task(work_stealing_pool& pool, int arr[], int l, int r)
+{
+    while(r - l + 1 > PARALLEL_CUTOFF)
+    {
+        int i = partition2(arr, l, r);
+        if(i - l > r - i) {
+            pool.submit([&pool, arr, l, i]{ parallel_quick_sort_task(pool, arr, l, i - 1); });
+            l = i + 1;
+        } else {
+            pool.submit([&pool, arr, i, r]{ parallel_quick_sort_task(pool, arr, i + 1, r); });
+            r = i - 1;
+        }
+    }
+    quick_sort2(arr, l, r);
+}
+
+/*
+* @brief 并行快速排序
+* @param arr/l/r：与 quick_sort2 相同，排序闭区间 [l, r]
+*        num_threads：参与排序的线程数，0 表示使用 hardware_concurrency()
+*/
+void parallel_quick_sort(int arr[], int l, int r, unsigned num_threads = 0)
+{
+    if(r - l + 1 <= PARALLEL_CUTOFF) {
+        quick_sort2(arr, l, r);
+        return;
+    }
+    if(num_threads == 0) {
+        num_threads = thread::hardware_concurrency();
+        if(num_threads == 0)
+            num_threads = 2; // 硬件信息不可用时默认2线程
+    }
+
+    work_stealing_pool pool(num_threads);
+    pool.submit([&pool, arr, l, r]{ parallel_quick_sort_task(pool, arr, l, r); });
+    pool.wait_idle();
+}
+
+// 计时工具：返回执行 f 所用的毫秒数
+template<typename F>
+double time_ms(F&& f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+vector<int> random_ints(size_t n, unsigned seed = 42)
+{
+    mt19937 rng(seed);
+    vector<int> v(n);
+    for(auto& x : v)
+        x = static_cast<int>(rng());
+    return v;
+}
+
+void test_parallel_quick_sort()
+{
+    for(size_t n : {0, 1, 100, 100000, 1000000}) {
+        vector<int> v = random_ints(n);
+        vector<int> expect = v;
+        sort(expect.begin(), expect.end());
+        if(n > 0)
+            parallel_quick_sort(v.data(), 0, static_cast<int>(n) - 1);
+        if(v != expect) {
+            cout << "parallel_quick_sort failed at n = " << n << endl;
+            return;
+        }
+    }
+    cout << "parallel_quick_sort test passed." << endl;
+}
+
+// 对抗性输入：这些分布会让 quick_sort2 退化为 O(n^2)，或者递归过深导致栈溢出
+vector<int> make_pattern(const string& name, size_t n)
+{
+    vector<int> v(n);
+    mt19937 rng(42);
+    for(size_t i = 0; i < n; i++)
+    {
+        if(name == "random")          v[i] = static_cast<int>(rng());
+        else if(name == "sorted")     v[i] = static_cast<int>(i);
+        else if(name == "reversed")   v[i] = static_cast<int>(n - i);
+        else if(name == "all_equal")  v[i] = 7;
+        else if(name == "few_unique") v[i] = static_cast<int>(i * 4 / n); // 有序且只有4种取值
+        else if(name == "organ_pipe") v[i] = static_cast<int>(i < n / 2 ? i : n - i);
+        else if(name == "sawtooth")   v[i] = static_cast<int>(i % 1000);
+    }
+    return v;
+}
+
+const vector<string> SORT_PATTERNS = {
+    "random", "sorted", "reversed", "all_equal", "few_unique", "organ_pipe", "sawtooth"
+};
+
+void test_intro_sort()
+{
+    for(const string& name : SORT_PATTERNS) {
+        for(size_t n : {0, 1, 2, 15, 16, 17, 200, 100000}) {
+            vector<int> v = make_pattern(name, n);
+            vector<int> expect = v;
+            sort(expect.begin(), expect.end());
+            if(n > 0)
+                intro_sort(v.data(), 0, static_cast<int>(n) - 1);
+            if(v != expect) {
+                cout << "intro_sort failed on " << name << ", n = " << n << endl;
+                return;
+            }
+        }
+    }
+    // 堆排序兜底路径单独验证
+    vector<int> v = random_ints(1000), expect = v;
+    sort(expect.begin(), expect.end());
+    heap_sort(v.data(), 0, 999);
+    if(v != expect) {
+        cout << "heap_sort failed" << endl;
+        return;
+    }
+    cout << "intro_sort test passed." << endl;
+}
+
+/*
+    对抗性输入基准：
+        quick_sort2 只在小规模下测试（all_equal 等输入是 O(n^2)，规模大了要跑很久甚至栈溢出）；
+        intro_sort 在大规模下测试，各输入分布的耗时都不应明显超过随机输入，worst/random 比值即最坏情况相对平均情况的放大倍数。
+*/
+void bench_adversarial()
+{
+    const size_t small_n = 20000, large_n = 10000000;
+    double worst = 0, random_ms = 0;
+    for(const string& name : SORT_PATTERNS) {
+        const vector<int> small_src = make_pattern(name, small_n);
+        const vector<int> large_src = make_pattern(name, large_n);
+        vector<int> v;
+
+        v = small_src;
+        double t_qs2 = time_ms([&]{ quick_sort2(v.data(), 0, static_cast<int>(small_n) - 1); });
+        v = small_src;
+        double t_intro_small = time_ms([&]{ intro_sort(v.data(), 0, static_cast<int>(small_n) - 1); });
+        v = large_src;
+        double t_intro_large = time_ms([&]{ intro_sort(v.data(), 0, static_cast<int>(large_n) - 1); });
+        v = large_src;
+        double t_std = time_ms([&]{ sort(v.begin(), v.end()); });
+
+        worst = max(worst, t_intro_large);
+        if(name == "random")
+            random_ms = t_intro_large;
+        cout << name
+             << "  n=" << small_n << " quick_sort2: " << t_qs2 << " ms, intro_sort: " << t_intro_small << " ms"
+             << " | n=" << large_n << " intro_sort: " << t_intro_large << " ms, std::sort: " << t_std << " ms" << endl;
+    }
+    cout << "intro_sort worst/random ratio at n=" << large_n << ": " << worst / random_ms << endl;
+}
+
+void test_simd_quick_sort()
+{
+    vector<partition_kernel> kernels = {partition_scalar};
+#ifdef QS_HAVE_AVX2_KERNEL
+    if(PARTITION_KERNEL == partition_avx2)
+        kernels.push_back(partition_avx2);
+#endif
+    for(partition_kernel kernel : kernels) {
+        // 直接校验划分结果，包括 INT_MIN/INT_MAX 等边界值
+        for(int n : {1, 15, 16, 17, 63, 64, 65, 100, 1000}) {
+            vector<int> v = random_ints(n, n);
+            v[0] = INT_MIN;
+            v[n - 1] = INT_MAX;
+            vector<int> before = v;
+            int pivot = v[n / 2];
+            int k = kernel(v.data(), n, pivot);
+            bool ok = is_permutation(v.begin(), v.end(), before.begin());
+            for(int i = 0; i < n; i++)
+                ok = ok && ((i < k) == (v[i] < pivot));
+            if(!ok) {
+                cout << "partition kernel failed at n = " << n << endl;
+                return;
+            }
+        }
+
+        for(const string& name : SORT_PATTERNS) {
+            for(size_t n : {1, 17, 100, 100000}) {
+                vector<int> v = make_pattern(name, n);
+                vector<int> expect = v;
+                sort(expect.begin(), expect.end());
+                simd_quick_sort(v.data(), 0, static_cast<int>(n) - 1, kernel);
+                if(v != expect) {
+                    cout << "simd_quick_sort failed on " << name << ", n = " << n << endl;
+                    return;
+                }
+            }
+        }
+    }
+    cout << "simd_quick_sort test passed (" << kernels.size() << " kernel(s))." << endl;
+}
+
+// 随机32位键上比较各排序的吞吐量（百万键/秒）
+void bench_simd_sort()
+{
+#ifdef QS_HAVE_AVX2_KERNEL
+    cout << "selected kernel: " << (PARTITION_KERNEL == partition_avx2 ? "avx2" : "scalar") << endl;
+#endif
+    for(size_t n : {100000, 1000000, 10000000}) {
+        const vector<int> src = random_ints(n);
+        int r = static_cast<int>(n) - 1;
+        vector<int> v;
+        auto mkeys = [n](double ms){ return n / ms / 1000.0; };
+
+        v = src;
+        double t_qs2 = time_ms([&]{ quick_sort2(v.data(), 0, r); });
+        v = src;
+        double t_std = time_ms([&]{ sort(v.begin(), v.end()); });
+        v = src;
+        double t_scalar = time_ms([&]{ simd_quick_sort(v.data(), 0, r, partition_scalar); });
+        v = src;
+        double t_simd = time_ms([&]{ simd_quick_sort(v.data(), 0, r); });
+
+        cout << "n = " << n
+             << "  quick_sort2: " << mkeys(t_qs2) << " Mkeys/s"
+             << "  std::sort: " << mkeys(t_std) << " Mkeys/s"
+             << "  scalar kernel: " << mkeys(t_scalar) << " Mkeys/s"
+             << "  dispatched kernel: " << mkeys(t_simd) << " Mkeys/s"
+             << "  speedup vs quick_sort2: " << t_qs2 / t_simd << "x" << endl;
+    }
+}
+
+/*
+    基准测试：随机 int，分别用 quick_sort2、std::sort、parallel_quick_sort 排序同一份数据。
+    100M 元素时每份数据约 400MB，需要约 1GB 内存。
+*/
+void bench_parallel_sort()
+{
+    unsigned hw = thread::hardware_concurrency();
+    cout << "hardware_concurrency = " << hw << endl;
+
+    for(size_t n : {1000000, 10000000, 100000000}) {
+        const vector<int> src = random_ints(n);
+        vector<int> v;
+        int r = static_cast<int>(n) - 1;
+
+        v = src;
+        double t_qs2 = time_ms([&]{ quick_sort2(v.data(), 0, r); });
+        v = src;
+        double t_std = time_ms([&]{ sort(v.begin(), v.end()); });
+        v = src;
+        double t_par = time_ms([&]{ parallel_quick_sort(v.data(), 0, r); });
+
+        cout << "n = " << n
+             << "  quick_sort2: " << t_qs2 << " ms"
+             << "  std::sort: " << t_std << " ms"
+             << "  parallel_quick_sort: " << t_par << " ms"
+             << "  speedup vs quick_sort2: " << t_qs2 / t_par << "x" << endl;
+    }
+
+    // 线程数扩展性：固定 10M 元素，线程数从 1 翻倍到 hardware_concurrency()
+    const size_t n = 10000000;
+    const vector<int> src = random_ints(n);
+    double base = 0;
+    for(unsigned t = 1; t <= max(hw, 1u); t *= 2) {
+        vector<int> v = src;
+        double ms = time_ms([&]{ parallel_quick_sort(v.data(), 0, static_cast<int>(n) - 1, t); });
+        if(t == 1)
+            base = ms;
+        cout << "threads = " << t << "  " << ms << " ms  scaling: " << base / ms << "x" << endl;
     }
 }
 
@@ -66,5 +831,13 @@ int main()
     {
         cout << x << " ";
     }
+    cout << endl;
+
+    test_intro_sort();
+    test_simd_quick_sort();
+    test_parallel_quick_sort();
+    // bench_adversarial();
+    // bench_simd_sort();
+    // bench_parallel_sort();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include "generic_sort.hpp"
+using namespace std;
+
+// g++ .\radix_sort.cpp -std=c++17 -O2 -pthread
+
+/*
+    LSD（最低位优先）基数排序：
+        把键按 DIGIT_BITS 位切成若干“位”，从最低位开始，每一趟按当前位做一次稳定的计数排序；
+        每趟只需顺序读一遍、分散写一遍，复杂度 O(n * 趟数)，与比较次数无关，适合带宽受限的整数键排序。
+    要求键能映射为“无符号整数序与原序一致”的形式，见 radix_traits。
+*/
+
+// 把 T 映射为无符号键，使得无符号比较的结果与 T 的 < 一致
+template<typename T>
+struct radix_traits;
+
+template<>
+struct radix_traits<uint32_t> {
+    using key_type = uint32_t;
+    static key_type to_key(uint32_t x) { return x; }
+};
+
+template<>
+struct radix_traits<uint64_t> {
+    using key_type = uint64_t;
+    static key_type to_key(uint64_t x) { return x; }
+};
+
+// 有符号整数：翻转符号位，负数就排到了正数前面
+template<>
+struct radix_traits<int32_t> {
+    using key_type = uint32_t;
+    static key_type to_key(int32_t x) { return static_cast<uint32_t>(x) ^ 0x80000000u; }
+};
+
+template<>
+struct radix_traits<int64_t> {
+    using key_type = uint64_t;
+    static key_type to_key(int64_t x) { return static_cast<uint64_t>(x) ^ 0x8000000000000000ull; }
+};
+
+/*
+    IEEE 浮点数（sign-flip 技巧）：
+        正数：只翻转符号位，使其大于所有负数；
+        负数：翻转全部位，绝对值越大的负数键越小。
+    NaN 会被排到两端。
+*/
+template<>
+struct radix_traits<float> {
+    using key_type = uint32_t;
+    static key_type to_key(float x) {
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        uint32_t mask = static_cast<uint32_t>(-static_cast<int32_t>(bits >> 31)) | 0x80000000u;
+        return bits ^ mask;
+    }
+};
+
+template<>
+struct radix_traits<double> {
+    using key_type = uint64_t;
+    static key_type to_key(double x) {
+        uint64_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        uint64_t mask = static_cast<uint64_t>(-static_cast<int64_t>(bits >> 63)) | 0x8000000000000000ull;
+        return bits ^ mask;
+    }
+};
+
+template<typename T, int DIGIT_BITS>
+struct radix_layout {
+    using key_type = typename radix_traits<T>::key_type;
+    static constexpr int PASSES = (static_cast<int>(sizeof(key_type)) * 8 + DIGIT_BITS - 1) / DIGIT_BITS;
+    static constexpr size_t BUCKETS = size_t(1) << DIGIT_BITS;
+
+    static size_t digit(key_type key, int pass) {
+        return static_cast<size_t>(key >> (pass * DIGIT_BITS)) & (BUCKETS - 1);
+    }
+};
+
+// 在 num_threads 个线程上执行 f(t)，0 号任务由调用线程执行
+template<typename F>
+void run_parallel(unsigned num_threads, F f)
+{
+    vector<thread> threads;
+    for(unsigned t = 1; t < num_threads; t++)
+        threads.emplace_back(f, t);
+    f(0);
+    for(auto& t : threads)
+        t.join();
+}
+
+constexpr size_t RADIX_MIN_PER_THREAD = 1 << 16; // 每个线程至少处理的元素数，太少时线程开销得不偿失
+
+/*
+* @brief LSD 基数排序
+* @template param
+*   T：uint32_t/int32_t/uint64_t/int64_t/float/double
+*   DIGIT_BITS：每趟处理的位数（8 或 11），11 位时 32 位键只需 3 趟
+* @param data/n：待排序数组
+*        num_threads：线程数，大于 1 时直方图统计和分散写都按块并行（结果仍然稳定）
+*/
+template<typename T, int DIGIT_BITS = 11>
+void radix_sort(T* data, size_t n, unsigned num_threads = 1)
+{
+    static_assert(DIGIT_BITS == 8 || DIGIT_BITS == 11, "DIGIT_BITS should be 8 or 11");
+    using layout = radix_layout<T, DIGIT_BITS>;
+    constexpr int PASSES = layout::PASSES;
+    constexpr size_t BUCKETS = layout::BUCKETS;
+
+    if(n < 2)
+        return;
+    num_threads = static_cast<unsigned>(max<size_t>(1, min<size_t>(num_threads, n / RADIX_MIN_PER_THREAD)));
+    auto chunk_begin = [n, num_threads](unsigned t) { return n * t / num_threads; };
+
+    // 1. 只读一遍数据，同时统计所有趟的直方图（每个线程统计自己的块）
+    vector<vector<size_t>> hist(num_threads, vector<size_t>(PASSES * BUCKETS));
+    run_parallel(num_threads, [&](unsigned t) {
+        size_t* h = hist[t].data();
+        for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); i++) {
+            auto key = radix_traits<T>::to_key(data[i]);
+            for(int pass = 0; pass < PASSES; pass++)
+                h[pass * BUCKETS + layout::digit(key, pass)]++;
+        }
+    });
+
+    vector<size_t> total(PASSES * BUCKETS);
+    for(unsigned t = 0; t < num_threads; t++)
+        for(size_t k = 0; k < total.size(); k++)
+            total[k] += hist[t][k];
+
+    vector<T> buffer(n);
+    T* src = data;
+    T* dst = buffer.data();
+    vector<vector<size_t>> offsets(num_threads, vector<size_t>(BUCKETS));
+    bool scattered = false; // 是否已经做过分散写（之后各块的内容就变了）
+
+    for(int pass = 0; pass < PASSES; pass++)
+    {
+        // 2. 所有键在这一位上都相同，这一趟不会改变顺序，直接跳过（例如小范围整数的高位）
+        const size_t* pass_total = total.data() + pass * BUCKETS;
+        if(*max_element(pass_total, pass_total + BUCKETS) == n)
+            continue;
+
+        /*
+            3. 计算每个线程在每个桶中的写入起点：
+                桶 b 的起点 = 前面所有桶的元素总数；桶内再按线程编号依次排列，保证稳定性。
+            第一趟之后各块中的元素已经变了，多线程时需要重新统计本块在这一位上的直方图；
+            单线程时整块就是整个数组，直接使用第1步的结果。
+        */
+        if(num_threads > 1 && scattered) {
+            run_parallel(num_threads, [&](unsigned t) {
+                size_t* h = hist[t].data() + pass * BUCKETS;
+                fill(h, h + BUCKETS, 0);
+                for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); i++)
+                    h[layout::digit(radix_traits<T>::to_key(src[i]), pass)]++;
+            });
+        }
+        size_t sum = 0;
+        for(size_t b = 0; b < BUCKETS; b++) {
+            for(unsigned t = 0; t < num_threads; t++) {
+                offsets[t][b] = sum;
+                sum += hist[t][pass * BUCKETS + b];
+            }
+        }
+
+        // 4. 分散写：每个线程把自己块中的元素写到各桶的对应位置
+        run_parallel(num_threads, [&](unsigned t) {
+            size_t* off = offsets[t].data();
+            for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); i++)
+                dst[off[layout::digit(radix_traits<T>::to_key(src[i]), pass)]++] = src[i];
+        });
+        swap(src, dst);
+        scattered = true;
+    }
+
+    // 趟数为奇数（或跳过了若干趟）时结果在缓冲区中，拷回原数组
+    if(src != data)
+        memcpy(data, src, n * sizeof(T));
+}
+
+template<typename T>
+void radix_sort(vector<T>& v, unsigned num_threads = 1)
+{
+    radix_sort(v.data(), v.size(), num_threads);
+}
+
+template<typename F>
+double time_ms(F&& f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+template<typename T>
+vector<T> random_values(size_t n, unsigned seed = 42)
+{
+    mt19937_64 rng(seed);
+    vector<T> v(n);
+    for(auto& x : v) {
+        if constexpr (is_floating_point_v<T>)
+            x = static_cast<T>(static_cast<int64_t>(rng()) / 1e6);
+        else
+            x = static_cast<T>(rng());
+    }
+    return v;
+}
+
+template<typename T>
+bool check_radix_sort(vector<T> v, unsigned num_threads)
+{
+    vector<T> expect = v;
+    std::sort(expect.begin(), expect.end());
+    radix_sort(v, num_threads);
+    return v == expect;
+}
+
+void test_radix_sort()
+{
+    for(unsigned threads : {1u, 4u}) {
+        for(size_t n : {0, 1, 2, 1000, 300000}) {
+            assert(check_radix_sort(random_values<uint32_t>(n), threads));
+            assert(check_radix_sort(random_values<int32_t>(n), threads));
+            assert(check_radix_sort(random_values<uint64_t>(n), threads));
+            assert(check_radix_sort(random_values<int64_t>(n), threads));
+            assert(check_radix_sort(random_values<float>(n), threads));
+            assert(check_radix_sort(random_values<double>(n), threads));
+        }
+    }
+
+    // 8 位一趟
+    vector<int32_t> v = random_values<int32_t>(100000), expect = v;
+    std::sort(expect.begin(), expect.end());
+    radix_sort<int32_t, 8>(v.data(), v.size());
+    assert(v == expect);
+
+    // 小范围键：高位全部相同，对应的趟会被跳过
+    vector<uint64_t> small(100000);
+    for(size_t i = 0; i < small.size(); i++) small[i] = (i * 7919) % 1000;
+    assert(check_radix_sort(small, 1));
+
+    // 正负零、负数、极值
+    vector<float> f = {3.5f, -0.0f, 0.0f, -1e30f, 1e30f, -2.25f, 1.0f, -1.0f};
+    radix_sort(f);
+    assert(is_sorted(f.begin(), f.end()));
+
+    cout << "Radix sort test passed.\n";
+}
+
+/*
+    基准测试：随机键，规模从 1K 到 10M，对比 gsort::sort（内省快速排序）、std::sort 与基数排序，
+    找出基数排序开始超过快速排序的规模。小规模时重复多次取平均。
+*/
+template<typename T>
+void bench_radix_vs_quicksort(const char* type_name)
+{
+    unsigned hw = max(thread::hardware_concurrency(), 1u);
+    cout << "---- " << type_name << " (" << hw << " threads for parallel radix) ----\n";
+    size_t crossover = 0;
+    for(size_t n = 1000; n <= 10000000; n *= 10) {
+        const vector<T> src = random_values<T>(n);
+        size_t reps = max<size_t>(1, 10000000 / n);
+        double t_quick = 0, t_std = 0, t_radix = 0, t_radix_mt = 0;
+        for(size_t r = 0; r < reps; r++) {
+            vector<T> v = src;
+            t_quick += time_ms([&]{ gsort::sort(v.begin(), v.end()); });
+            v = src;
+            t_std += time_ms([&]{ std::sort(v.begin(), v.end()); });
+            v = src;
+            t_radix += time_ms([&]{ radix_sort(v); });
+            v = src;
+            t_radix_mt += time_ms([&]{ radix_sort(v, hw); });
+        }
+        if(crossover == 0 && t_radix < t_quick)
+            crossover = n;
+        cout << "n = " << n
+             << "  gsort::sort: " << t_quick / reps << " ms"
+             << "  std::sort: " << t_std / reps << " ms"
+             << "  radix: " << t_radix / reps << " ms"
+             << "  radix(mt): " << t_radix_mt / reps << " ms\n";
+    }
+    if(crossover)
+        cout << "radix sort overtakes quicksort from n = " << crossover << "\n";
+}
+
+void bench_radix_sort()
+{
+    bench_radix_vs_quicksort<int32_t>("int32_t");
+    bench_radix_vs_quicksort<uint64_t>("uint64_t");
+    bench_radix_vs_quicksort<float>("float");
+    bench_radix_vs_quicksort<double>("double");
+}
+
+int main()
+{
+    test_radix_sort();
+    // bench_radix_sort();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include "generic_sort.hpp"
+using namespace std;
+
+// g++ .\top_k.cpp -std=c++17 -O2 -pthread
+
+/*
+    Top-K：只需要最大的 k 个元素时，完整排序做了大量无用功。
+        gsort::nth_element：快速选择，期望 O(n)，会重排原数组；
+        gsort::partial_sort：快速选择 + 只排序前 k 个，O(n + klogk)；
+        bounded_heap_top_k：大小为 k 的小顶堆，只读遍历一次，不修改输入，O(nlogk)，但绝大多数元素只和堆顶比较一次；
+        parallel_top_k：每个线程对自己的块维护一个有界堆，最后把各线程的 k 个候选合并。
+    以下函数都返回按从大到小排列的 k 个元素。
+*/
+
+// 有界小顶堆：堆顶是当前候选中最小的，新元素只有比它大时才入堆
+template<typename T>
+class bounded_heap
+{
+    vector<T> _heap;
+    size_t _k;
+
+public:
+    explicit bounded_heap(size_t k) : _k(k) { _heap.reserve(k); }
+
+    void push(const T& value) {
+        if(_heap.size() < _k) {
+            _heap.push_back(value);
+            push_heap(_heap.begin(), _heap.end(), greater<T>());
+        } else if(_k > 0 && _heap.front() < value) {
+            pop_heap(_heap.begin(), _heap.end(), greater<T>());
+            _heap.back() = value;
+            push_heap(_heap.begin(), _heap.end(), greater<T>());
+        }
+    }
+
+    // 取出全部候选，从大到小排列
+    vector<T> take_sorted() {
+        sort_heap(_heap.begin(), _heap.end(), greater<T>());
+        return move(_heap);
+    }
+};
+
+template<typename T>
+vector<T> bounded_heap_top_k(const T* data, size_t n, size_t k)
+{
+    bounded_heap<T> heap(k);
+    for(size_t i = 0; i < n; i++)
+        heap.push(data[i]);
+    return heap.take_sorted();
+}
+
+/*
+* @brief 多线程 top-k
+* @param data/n：输入数组（只读）
+*        k：需要的元素个数
+*        num_threads：线程数，0 表示使用 hardware_concurrency()
+*/
+template<typename T>
+vector<T> parallel_top_k(const T* data, size_t n, size_t k, unsigned num_threads = 0)
+{
+    if(num_threads == 0)
+        num_threads = max(thread::hardware_concurrency(), 1u);
+    // 每个线程至少处理 max(k, 64K) 个元素，否则线程开销超过收益
+    size_t min_per_thread = max<size_t>(k, 1 << 16);
+    num_threads = static_cast<unsigned>(max<size_t>(1, min<size_t>(num_threads, n / min_per_thread)));
+
+    // 1. 各线程在自己的块上维护有界堆，互不共享，无需加锁
+    vector<vector<T>> partial(num_threads);
+    vector<thread> threads;
+    auto work = [&](unsigned t) {
+        size_t begin = n * t / num_threads, end = n * (t + 1) / num_threads;
+        partial[t] = bounded_heap_top_k(data + begin, end - begin, k);
+    };
+    for(unsigned t = 1; t < num_threads; t++)
+        threads.emplace_back(work, t);
+    work(0);
+    for(auto& t : threads)
+        t.join();
+
+    // 2. 合并：至多 num_threads * k 个候选，再选一次前 k 个
+    vector<T> candidates;
+    for(auto& p : partial)
+        candidates.insert(candidates.end(), p.begin(), p.end());
+    size_t m = min(k, candidates.size());
+    gsort::partial_sort(candidates.begin(), candidates.begin() + m, candidates.end(), greater<>());
+    candidates.resize(m);
+    return candidates;
+}
+
+template<typename F>
+double time_ms(F&& f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+vector<int> random_ints(size_t n, unsigned seed = 42)
+{
+    mt19937 rng(seed);
+    vector<int> v(n);
+    for(auto& x : v)
+        x = static_cast<int>(rng());
+    return v;
+}
+
+void test_nth_element()
+{
+    for(size_t n : {1, 2, 17, 1000, 100000}) {
+        for(int distinct : {3, 1 << 30}) {
+            vector<int> v = random_ints(n);
+            for(auto& x : v) x %= distinct;
+            vector<int> sorted = v;
+            std::sort(sorted.begin(), sorted.end());
+            for(size_t nth : {size_t(0), n / 3, n - 1}) {
+                vector<int> w = v;
+                gsort::nth_element(w.begin(), w.begin() + nth, w.end());
+                assert(w[nth] == sorted[nth]);
+                assert(all_of(w.begin(), w.begin() + nth, [&](int x){ return x <= w[nth]; }));
+                assert(all_of(w.begin() + nth, w.end(), [&](int x){ return x >= w[nth]; }));
+            }
+            // 非算术类型走三路划分路径
+            vector<string> s;
+            for(size_t i = 0; i < min<size_t>(n, 2000); i++) s.push_back(to_string(v[i]));
+            vector<string> s_sorted = s;
+            std::sort(s_sorted.begin(), s_sorted.end());
+            gsort::nth_element(s.begin(), s.begin() + s.size() / 2, s.end());
+            assert(s[s.size() / 2] == s_sorted[s.size() / 2]);
+        }
+    }
+    cout << "nth_element test passed.\n";
+}
+
+void test_top_k()
+{
+    for(size_t n : {0, 5, 1000, 1000000}) {
+        vector<int> v = random_ints(n);
+        vector<int> expect = v;
+        std::sort(expect.begin(), expect.end(), greater<>());
+        for(size_t k : {size_t(1), size_t(10), size_t(1000)}) {
+            size_t m = min(k, n);
+            vector<int> top(expect.begin(), expect.begin() + m);
+
+            vector<int> w = v;
+            gsort::partial_sort(w.begin(), w.begin() + m, w.end(), greater<>());
+            assert(equal(top.begin(), top.end(), w.begin()));
+            assert(bounded_heap_top_k(v.data(), n, k) == top);
+            assert(parallel_top_k(v.data(), n, k, 4) == top);
+        }
+    }
+    cout << "Top-k test passed.\n";
+}
+
+/*
+    基准测试：从 n 个随机 int 中取最大的 k 个（默认 100M 取 1000，输入和一份拷贝共约 800MB 内存）。
+    排序类方法需要先拷贝一份数据（会修改输入），拷贝时间不计入。
+*/
+void bench_top_k(size_t n = 100000000, size_t k = 1000)
+{
+    const vector<int> src = random_ints(n);
+    vector<int> v;
+    cout << "n = " << n << ", k = " << k << ", threads = " << max(thread::hardware_concurrency(), 1u) << endl;
+
+    v = src;
+    double t_sort = time_ms([&]{ gsort::sort(v.begin(), v.end(), greater<>()); });
+    v = src;
+    double t_std_partial = time_ms([&]{ std::partial_sort(v.begin(), v.begin() + k, v.end(), greater<>()); });
+    v = src;
+    double t_partial = time_ms([&]{ gsort::partial_sort(v.begin(), v.begin() + k, v.end(), greater<>()); });
+    v = src;
+    double t_nth = time_ms([&]{ gsort::nth_element(v.begin(), v.begin() + k - 1, v.end(), greater<>()); });
+    double t_heap = time_ms([&]{ bounded_heap_top_k(src.data(), n, k); });
+    double t_parallel = time_ms([&]{ parallel_top_k(src.data(), n, k); });
+
+    cout << "full gsort::sort:       " << t_sort << " ms\n"
+         << "std::partial_sort:      " << t_std_partial << " ms\n"
+         << "gsort::partial_sort:    " << t_partial << " ms\n"
+         << "gsort::nth_element:     " << t_nth << " ms (unsorted top-k)\n"
+         << "bounded heap:           " << t_heap << " ms\n"
+         << "parallel bounded heaps: " << t_parallel << " ms\n";
+}
+
+int main()
+{
+    test_nth_element();
+    test_top_k();
+    // bench_top_k();
+
+    return 0;
+}
\ No newline at end of file
@@ -4,6 +4,22 @@
 #include <vector>
 #include <mutex>
 #include <numeric>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <tuple>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <optional>
+#include <iterator>
+#include <list>
+#include <string>
+#include <random>
+#include <cassert>
 using namespace std;
 
 void some_function()
@@ -351,9 +367,687 @@ void use_parallel_accumulate()
     cout << "sum is " << sum << endl;
 }
 
+/*
+    工作窃取线程池：上面的 use_vector、safe_concurrency、parallel_accumulate 每次都新建线程，
+    创建和销毁一个线程要几十微秒，任务本身很小时大部分时间花在线程管理上。
+    work_stealing_pool 启动时创建固定数量的工作线程（joining_thread，析构时保证全部汇合），之后反复使用：
+        每个工作线程有自己的双端队列（Chase-Lev deque），自己从底部压入/弹出（后进先出，缓存友好），
+        空闲的线程随机挑选其他线程，从其队列顶部窃取（先进先出，偷走的通常是较大的任务）；
+        非工作线程提交的任务放入一个共享的注入队列；
+        找不到任务时先短暂自旋，仍然没有再在条件变量上睡眠，有新任务时才唤醒（只有存在睡眠者时才加锁通知）。
+    等待子任务时（parallel_for、parallel_invoke、get）调用线程不会阻塞，而是帮忙执行队列中的任务，
+    因此在任务内部嵌套使用这些接口也不会因为所有工作线程都在等待而死锁。
+*/
+
+/*
+    Chase-Lev 双端队列（Lê 等人 2013 年的 C11 版本）：只有所属线程调用 push/pop，任意线程可以调用 steal。
+    元素保存在环形数组中，满了换成两倍大小的新数组；旧数组可能仍被窃取者读取，留到队列销毁时再释放。
+    原论文中的独立内存栅栏改为对 top/bottom 的 seq_cst 操作，效果相同（ThreadSanitizer 也能理解）。
+*/
+template<typename T>
+class work_stealing_deque
+{
+    struct ring {
+        int64_t mask;
+        unique_ptr<atomic<T>[]> slots;
+
+        explicit ring(int64_t capacity) : mask(capacity - 1), slots(new atomic<T>[capacity]()) {}
+        int64_t capacity() const { return mask + 1; }
+        T get(int64_t i) const { return slots[i & mask].load(memory_order_relaxed); }
+        void put(int64_t i, T v) { slots[i & mask].store(v, memory_order_relaxed); }
+    };
+
+    alignas(64) atomic<int64_t> top{0};    // 窃取端
+    alignas(64) atomic<int64_t> bottom{0}; // 所属线程端
+    atomic<ring*> array;
+    vector<unique_ptr<ring>> rings; // 所有分配过的数组（只由所属线程修改）
+
+public:
+    explicit work_stealing_deque(int64_t capacity = 256) {
+        rings.push_back(make_unique<ring>(capacity));
+        array.store(rings.back().get(), memory_order_relaxed);
+    }
+
+    void push(T v) {
+        int64_t b = bottom.load(memory_order_relaxed);
+        int64_t t = top.load(memory_order_acquire);
+        ring* a = array.load(memory_order_relaxed);
+        if(b - t > a->capacity() - 1) {
+            rings.push_back(make_unique<ring>(a->capacity() * 2));
+            ring* bigger = rings.back().get();
+            for(int64_t i = t; i < b; i++)
+                bigger->put(i, a->get(i));
+            array.store(bigger, memory_order_release);
+            a = bigger;
+        }
+        a->put(b, v);
+        bottom.store(b + 1, memory_order_release);
+    }
+
+    // 所属线程从底部弹出，队列空时返回 T{}
+    T pop() {
+        int64_t b = bottom.load(memory_order_relaxed) - 1;
+        ring* a = array.load(memory_order_relaxed);
+        bottom.store(b, memory_order_seq_cst); // 先占住底部，再看窃取者是否也在拿同一个元素
+        int64_t t = top.load(memory_order_seq_cst);
+        if(t > b) {
+            bottom.store(b + 1, memory_order_relaxed); // 队列为空
+            return T{};
+        }
+        T v = a->get(b);
+        if(t == b) {
+            // 只剩最后一个元素，与窃取者竞争 top
+            if(!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                v = T{};
+            bottom.store(b + 1, memory_order_relaxed);
+        }
+        return v;
+    }
+
+    // 任意线程从顶部窃取，队列空或与其他线程竞争失败时返回 T{}
+    T steal() {
+        int64_t t = top.load(memory_order_seq_cst);
+        int64_t b = bottom.load(memory_order_seq_cst);
+        if(t >= b)
+            return T{};
+        T v = array.load(memory_order_acquire)->get(t);
+        if(!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+            return T{};
+        return v;
+    }
+};
+
+class work_stealing_pool
+{
+    using task = function<void()>;
+    static constexpr size_t NO_WORKER = static_cast<size_t>(-1);
+    static constexpr int SPIN_ROUNDS = 64;
+
+    struct worker {
+        work_stealing_deque<task*> tasks;
+        uint32_t rng; // 选择窃取对象用的 xorshift 状态
+    };
+
+    vector<unique_ptr<worker>> workers;
+    mutex inject_mutex;
+    deque<task*> injected;            // 非工作线程提交的任务
+    atomic<size_t> injected_size{0};  // 注入队列为空时不必加锁
+    atomic<int64_t> pending{0};       // 已提交、尚未被取走的任务数
+    mutex park_mutex;
+    condition_variable park_cv;
+    atomic<int> sleepers{0};
+    atomic<bool> stopping{false};
+    vector<joining_thread> threads;
+
+    // 当前线程所属的线程池和编号
+    inline static thread_local work_stealing_pool* current_pool = nullptr;
+    inline static thread_local size_t current_index = NO_WORKER;
+
+    size_t self_index() const { return current_pool == this ? current_index : NO_WORKER; }
+
+    void push(task* t) {
+        size_t self = self_index();
+        if(self != NO_WORKER) {
+            workers[self]->tasks.push(t);
+        } else {
+            if(stopping.load(memory_order_relaxed)) {
+                delete t;
+                throw runtime_error("work_stealing_pool is stopping");
+            }
+            lock_guard<mutex> lock(inject_mutex);
+            injected.push_back(t);
+            injected_size.fetch_add(1, memory_order_relaxed);
+        }
+        // 与 worker_loop 中的 sleepers/pending 构成 Dekker 式配对（均为 seq_cst），不会丢失唤醒
+        pending.fetch_add(1);
+        if(sleepers.load() > 0) {
+            lock_guard<mutex> lock(park_mutex); // 确保睡眠者要么还没检查条件，要么已经在等待
+            park_cv.notify_one();
+        }
+    }
+
+    task* take_injected() {
+        if(injected_size.load(memory_order_relaxed) == 0)
+            return nullptr;
+        lock_guard<mutex> lock(inject_mutex);
+        if(injected.empty())
+            return nullptr;
+        task* t = injected.front();
+        injected.pop_front();
+        injected_size.fetch_sub(1, memory_order_relaxed);
+        return t;
+    }
+
+    task* steal(size_t self) {
+        size_t n = workers.size();
+        size_t start;
+        if(self != NO_WORKER) {
+            uint32_t& x = workers[self]->rng;
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            start = x % n;
+        } else {
+            start = hash<thread::id>()(this_thread::get_id()) % n;
+        }
+        for(size_t k = 0; k < n; k++) {
+            size_t victim = (start + k) % n;
+            if(victim == self)
+                continue;
+            if(task* t = workers[victim]->tasks.steal())
+                return t;
+        }
+        return nullptr;
+    }
+
+    // 取一个任务执行：自己的队列 -> 注入队列 -> 随机窃取
+    bool run_one(size_t self) {
+        task* t = nullptr;
+        if(self != NO_WORKER)
+            t = workers[self]->tasks.pop();
+        if(!t)
+            t = take_injected();
+        if(!t)
+            t = steal(self);
+        if(!t)
+            return false;
+        pending.fetch_sub(1, memory_order_relaxed);
+        (*t)();
+        delete t;
+        return true;
+    }
+
+    void worker_loop(size_t index) {
+        current_pool = this;
+        current_index = index;
+        while(true) {
+            if(run_one(index))
+                continue;
+            // 刚空闲时很可能马上有新任务，先自旋一会儿，比睡眠后再被唤醒便宜
+            bool found = false;
+            for(int i = 0; i < SPIN_ROUNDS && !found; i++) {
+                this_thread::yield();
+                found = run_one(index);
+            }
+            if(found)
+                continue;
+            unique_lock<mutex> lock(park_mutex);
+            sleepers.fetch_add(1);
+            park_cv.wait(lock, [this]{ return stopping.load() || pending.load() > 0; });
+            sleepers.fetch_sub(1);
+            if(stopping.load() && pending.load() <= 0)
+                return; // 停止前先把已提交的任务执行完
+        }
+    }
+
+public:
+    explicit work_stealing_pool(size_t num_threads = max(1u, thread::hardware_concurrency())) {
+        for(size_t i = 0; i < num_threads; i++) {
+            workers.push_back(make_unique<worker>());
+            workers.back()->rng = static_cast<uint32_t>(i * 2654435761u + 1);
+        }
+        for(size_t i = 0; i < num_threads; i++)
+            threads.emplace_back(&work_stealing_pool::worker_loop, this, i);
+    }
+
+    ~work_stealing_pool() {
+        {
+            lock_guard<mutex> lock(park_mutex);
+            stopping.store(true);
+        }
+        park_cv.notify_all();
+        threads.clear(); // joining_thread 析构时汇合
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // 提交任务，通过 future 取得返回值或异常
+    template<typename Callable, typename ...Args>
+    auto submit(Callable&& func, Args&& ...args) {
+        using R = invoke_result_t<decay_t<Callable>, decay_t<Args>...>;
+        auto job = make_shared<packaged_task<R()>>(
+            [f = forward<Callable>(func), tup = make_tuple(forward<Args>(args)...)]() mutable {
+                return apply(move(f), move(tup));
+            });
+        future<R> result = job->get_future();
+        push(new task([job]{ (*job)(); }));
+        return result;
+    }
+
+    // 等待 future 就绪，期间帮忙执行其他任务（在任务内部等待子任务时不会占着工作线程空等）
+    template<typename T>
+    T get(future<T>& f) {
+        help_until([&]{ return f.wait_for(chrono::seconds(0)) == future_status::ready; });
+        return f.get();
+    }
+
+    template<typename Pred>
+    void help_until(Pred done) {
+        size_t self = self_index();
+        while(!done())
+            if(!run_one(self))
+                this_thread::yield();
+    }
+
+    /*
+    * @brief 对 [first, last) 中的每个下标调用 func(i)，按 grain 个下标一块切分成任务；
+    *        grain 为 0 时按线程数自动选择（每个线程约 8 块，便于负载均衡）。任务中的第一个异常在全部完成后重新抛出
+    */
+    template<typename Func>
+    void parallel_for(size_t first, size_t last, Func func, size_t grain = 0) {
+        if(first >= last)
+            return;
+        size_t n = last - first;
+        if(grain == 0)
+            grain = max<size_t>(1, n / (size() * 8));
+        size_t chunks = (n + grain - 1) / grain;
+        atomic<size_t> remaining(chunks);
+        exception_ptr error;
+        mutex error_mutex;
+        auto run_chunk = [&](size_t lo, size_t hi) {
+            try {
+                for(size_t i = lo; i < hi; i++)
+                    func(i);
+            } catch(...) {
+                lock_guard<mutex> lock(error_mutex);
+                if(!error) error = current_exception();
+            }
+            remaining.fetch_sub(1, memory_order_acq_rel);
+        };
+        // 第一块留给调用线程自己执行
+        for(size_t c = 1; c < chunks; c++) {
+            size_t lo = first + c * grain, hi = min(last, lo + grain);
+            push(new task([&run_chunk, lo, hi]{ run_chunk(lo, hi); }));
+        }
+        run_chunk(first, min(last, first + grain));
+        help_until([&]{ return remaining.load(memory_order_acquire) == 0; });
+        if(error)
+            rethrow_exception(error);
+    }
+
+    // 并行执行若干个函数，第一个由调用线程执行
+    template<typename First, typename ...Rest>
+    void parallel_invoke(First&& first, Rest&& ...rest) {
+        atomic<size_t> remaining(sizeof...(Rest));
+        exception_ptr error;
+        mutex error_mutex;
+        auto guarded = [&](auto& f) {
+            try {
+                f();
+            } catch(...) {
+                lock_guard<mutex> lock(error_mutex);
+                if(!error) error = current_exception();
+            }
+        };
+        (push(new task([&guarded, &remaining, &rest]{
+            guarded(rest);
+            remaining.fetch_sub(1, memory_order_acq_rel);
+        })), ...);
+        guarded(first);
+        help_until([&]{ return remaining.load(memory_order_acquire) == 0; });
+        if(error)
+            rethrow_exception(error);
+    }
+};
+
+void test_thread_pool()
+{
+    work_stealing_pool pool(4);
+
+    // submit：返回值与异常都通过 future 传回
+    auto f1 = pool.submit([](int a, int b) { return a + b; }, 2, 3);
+    auto f2 = pool.submit([]{ throw runtime_error("task failed"); });
+    assert(f1.get() == 5);
+    bool thrown = false;
+    try { f2.get(); } catch(const runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    // 大量小任务
+    atomic<int> counter(0);
+    vector<future<void>> futures;
+    for(int i = 0; i < 10000; i++)
+        futures.push_back(pool.submit([&counter]{ counter.fetch_add(1, memory_order_relaxed); }));
+    for(auto& f : futures) pool.get(f);
+    assert(counter == 10000);
+
+    // parallel_for：每个下标恰好执行一次
+    vector<int> hits(100000, 0);
+    pool.parallel_for(0, hits.size(), [&](size_t i) { hits[i]++; });
+    assert(count(hits.begin(), hits.end(), 1) == static_cast<long>(hits.size()));
+
+    // 任务内部嵌套 parallel_for/parallel_invoke/get，等待时帮忙执行，不会死锁
+    atomic<long> nested_sum(0);
+    pool.parallel_for(0, 16, [&](size_t i) {
+        pool.parallel_invoke(
+            [&]{ pool.parallel_for(0, 100, [&](size_t j) { nested_sum += static_cast<long>(i * 100 + j); }, 10); },
+            [&]{ auto f = pool.submit([]{ return 1; }); nested_sum += pool.get(f) - 1; });
+    }, 1);
+    assert(nested_sum == 1600L * 1599 / 2);
+
+    // parallel_for 中的异常在所有块完成后重新抛出
+    thrown = false;
+    try {
+        pool.parallel_for(0, 1000, [](size_t i) { if(i == 500) throw out_of_range("bad index"); });
+    } catch(const out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+    (void)thrown;
+    cout << "Thread pool test passed." << endl;
+}
+
+/*
+    任务创建开销：分别用“每个任务一个新线程”和线程池执行 kTasks 个空任务，单位 us/任务；
+    并行循环伸缩性：对 kElements 个元素做 kRounds 轮计算，“每轮新建 hardware_concurrency 个线程”（parallel_accumulate 的做法）
+    与线程池 parallel_for 对比，线程池大小从 1 到 8。
+*/
+void bench_thread_pool()
+{
+    using clock = chrono::steady_clock;
+    auto us_since = [](clock::time_point start) {
+        return chrono::duration<double, micro>(clock::now() - start).count();
+    };
+
+    const int kTasks = 20000;
+    atomic<int> counter(0);
+    auto start = clock::now();
+    for(int i = 0; i < kTasks; i++) {
+        thread t([&counter]{ counter++; });
+        t.join();
+    }
+    cout << "thread per task:      " << us_since(start) / kTasks << " us/task" << endl;
+    {
+        work_stealing_pool pool;
+        start = clock::now();
+        vector<future<void>> futures;
+        futures.reserve(kTasks);
+        for(int i = 0; i < kTasks; i++)
+            futures.push_back(pool.submit([&counter]{ counter++; }));
+        for(auto& f : futures) f.get();
+        cout << "pool submit + future: " << us_since(start) / kTasks << " us/task" << endl;
+        start = clock::now();
+        pool.parallel_for(0, kTasks, [&counter](size_t) { counter++; }, 1);
+        cout << "pool parallel_for(grain 1): " << us_since(start) / kTasks << " us/task" << endl;
+    }
+
+    const size_t kElements = 1 << 20;
+    const int kRounds = 50;
+    vector<double> values(kElements, 1.0);
+    auto work = [&](size_t i) { values[i] = sqrt(values[i] + static_cast<double>(i)); };
+    unsigned hw = max(1u, thread::hardware_concurrency());
+    start = clock::now();
+    for(int r = 0; r < kRounds; r++) {
+        vector<thread> ts;
+        size_t block = kElements / hw;
+        for(unsigned t = 0; t < hw; t++)
+            ts.emplace_back([&, t]{
+                size_t hi = t + 1 == hw ? kElements : (t + 1) * block;
+                for(size_t i = t * block; i < hi; i++) work(i);
+            });
+        for(auto& t : ts) t.join();
+    }
+    cout << "cpus = " << hw << ", thread per round: " << us_since(start) / kRounds << " us/round" << endl;
+    for(size_t n = 1; n <= 8; n *= 2) {
+        work_stealing_pool pool(n);
+        start = clock::now();
+        for(int r = 0; r < kRounds; r++)
+            pool.parallel_for(0, kElements, work);
+        cout << "pool threads = " << n << ": " << us_since(start) / kRounds << " us/round" << endl;
+    }
+}
+
+/*
+    通用的并行归约：parallel_accumulate 的几个问题——
+        只能用 + 累加；每次调用都新建线程；results 中相邻的元素在同一缓存行上，多个线程同时写会伪共享；
+        对非随机访问迭代器，每个线程的块起点都要 std::advance 一遍。
+    parallel_transform_reduce(first, last, init, reduce, transform, options) 计算 init ⊕ t(x0) ⊕ t(x1) ⊕ ...，
+    reduce 需满足结合律（与 std::reduce 相同，但不要求交换律：各块的结果严格按从左到右的顺序合并）。
+        分块：未指定 grain 时先顺序处理一小段前缀并计时，估算每个元素的代价，使每块大约 TARGET_CHUNK_NS，
+              同时保证每个线程至少分到几块；总工作量很小时直接顺序计算，不启动任何线程；
+        每块的部分结果放在独占一个缓存行的 padded_partial 中，块内在局部变量中累加；
+        非随机访问迭代器只遍历一次记录各块起点；
+        options.pool 不为空时在线程池上执行，否则临时创建 joining_thread；
+        浮点数加法不满足结合律，分块方式不同结果就可能不同：deterministic 为 true 时分块大小是固定值
+        （不计时，也与线程数无关），块的结果按顺序合并，同样的输入每次、每种线程数下都得到完全相同的结果。
+*/
+struct reduce_options {
+    work_stealing_pool* pool = nullptr; // 为空时每次调用临时创建线程
+    size_t grain = 0;                   // 每块的元素个数，0 表示自动选择
+    bool deterministic = false;
+};
+
+template<typename T>
+struct alignas(64) padded_partial {
+    optional<T> value; // T 不一定可以默认构造
+};
+
+template<typename Iterator, typename T, typename ReduceOp, typename TransformOp>
+T parallel_transform_reduce(Iterator first, Iterator last, T init, ReduceOp reduce, TransformOp transform,
+                            reduce_options options = {})
+{
+    constexpr size_t SAMPLE_ELEMENTS = 1024;
+    constexpr double TARGET_CHUNK_NS = 50000;   // 每块约 50us：远大于调度一个任务的开销，又足够细以均衡负载
+    constexpr double MIN_PARALLEL_NS = 100000;  // 剩余工作量少于 100us 时并行不划算
+    constexpr size_t DETERMINISTIC_GRAIN = 16384;
+    constexpr bool random_access =
+        is_base_of_v<random_access_iterator_tag, typename iterator_traits<Iterator>::iterator_category>;
+
+    size_t length = static_cast<size_t>(distance(first, last));
+    if(length == 0)
+        return init;
+
+    auto reduce_block = [&](Iterator it, size_t count) {
+        T acc = transform(*it);
+        for(size_t i = 1; i < count; i++) {
+            ++it;
+            acc = reduce(move(acc), transform(*it));
+        }
+        return acc;
+    };
+
+    static const size_t hardware_threads = max(1u, thread::hardware_concurrency()); // 每次查询要读系统文件，较慢
+    size_t workers = options.pool ? options.pool->size() : hardware_threads;
+    size_t grain = options.grain;
+    optional<T> prefix; // 计时用的前缀的结果，合并时排在所有块之前
+    if(grain == 0 && options.deterministic) {
+        grain = DETERMINISTIC_GRAIN;
+    } else if(grain == 0) {
+        size_t sample = min(length, SAMPLE_ELEMENTS);
+        auto start = chrono::steady_clock::now();
+        prefix = reduce_block(first, sample);
+        double ns_per_element = max(0.1, chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / sample);
+        advance(first, sample);
+        length -= sample;
+        if(length == 0 || ns_per_element * length < MIN_PARALLEL_NS) {
+            if(length > 0)
+                prefix = reduce(move(*prefix), reduce_block(first, length));
+            return reduce(move(init), move(*prefix));
+        }
+        grain = max<size_t>(1, static_cast<size_t>(TARGET_CHUNK_NS / ns_per_element));
+        grain = min(grain, (length + workers * 4 - 1) / (workers * 4));
+    }
+
+    size_t chunks = (length + grain - 1) / grain;
+    vector<Iterator> starts; // 非随机访问迭代器：一次遍历记录各块起点
+    if constexpr(!random_access) {
+        starts.reserve(chunks);
+        Iterator it = first;
+        for(size_t c = 0; c < chunks; c++) {
+            starts.push_back(it);
+            if(c + 1 < chunks)
+                advance(it, grain);
+        }
+    }
+    auto chunk_begin = [&](size_t c) {
+        if constexpr(random_access)
+            return first + static_cast<typename iterator_traits<Iterator>::difference_type>(c * grain);
+        else
+            return starts[c];
+    };
+
+    vector<padded_partial<T>> partials(chunks);
+    auto run_chunks = [&](size_t lo, size_t hi) {
+        for(size_t c = lo; c < hi; c++)
+            partials[c].value = reduce_block(chunk_begin(c), min(grain, length - c * grain));
+    };
+
+    if(chunks == 1) {
+        run_chunks(0, 1);
+    } else if(options.pool) {
+        options.pool->parallel_for(0, chunks, [&](size_t c) { run_chunks(c, c + 1); }, 1);
+    } else {
+        // 与 parallel_accumulate 相同：连续的若干块分给一个线程，最后一段由调用线程执行
+        size_t num_threads = min(workers, chunks);
+        vector<exception_ptr> errors(num_threads);
+        {
+            vector<joining_thread> threads;
+            for(size_t t = 0; t + 1 < num_threads; t++)
+                threads.emplace_back([&, t]{
+                    try {
+                        run_chunks(t * chunks / num_threads, (t + 1) * chunks / num_threads);
+                    } catch(...) {
+                        errors[t] = current_exception();
+                    }
+                });
+            try {
+                run_chunks((num_threads - 1) * chunks / num_threads, chunks);
+            } catch(...) {
+                errors[num_threads - 1] = current_exception();
+            }
+        } // joining_thread 析构时汇合
+        for(auto& e : errors)
+            if(e) rethrow_exception(e);
+    }
+
+    T result = move(init);
+    if(prefix)
+        result = reduce(move(result), move(*prefix));
+    for(auto& p : partials)
+        result = reduce(move(result), move(*p.value));
+    return result;
+}
+
+template<typename Iterator, typename T, typename ReduceOp = plus<>>
+T parallel_reduce(Iterator first, Iterator last, T init, ReduceOp reduce = {}, reduce_options options = {})
+{
+    return parallel_transform_reduce(first, last, move(init), reduce,
+                                     [](const auto& x) -> const auto& { return x; }, options);
+}
+
+void test_parallel_reduce()
+{
+    work_stealing_pool pool(4);
+    reduce_options on_pool;
+    on_pool.pool = &pool;
+
+    vector<long> values(1000000);
+    iota(values.begin(), values.end(), 1);
+    long expected = accumulate(values.begin(), values.end(), 0L);
+    assert(parallel_reduce(values.begin(), values.end(), 0L) == expected);
+    assert(parallel_reduce(values.begin(), values.end(), 0L, plus<>(), on_pool) == expected);
+    assert(parallel_reduce(values.begin(), values.begin(), 42L) == 42); // 空区间
+    assert(parallel_reduce(values.begin(), values.end(), 0L, [](long a, long b) { return max(a, b); }) == 1000000);
+
+    // 非随机访问迭代器
+    list<long> lst(values.begin(), values.begin() + 100000);
+    reduce_options small_grain;
+    small_grain.grain = 1000;
+    assert(parallel_reduce(lst.begin(), lst.end(), 0L, plus<>(), small_grain) == 100000L * 100001 / 2);
+
+    // 不满足交换律的运算（字符串拼接）：结果保持原来的顺序
+    string text;
+    for(int i = 0; i < 20000; i++) text += static_cast<char>('a' + i % 26);
+    reduce_options tiny_grain;
+    tiny_grain.grain = 7;
+    tiny_grain.pool = &pool;
+    auto concat = [](string a, const string& b) { return a + b; };
+    auto to_string = [](char c) { return string(1, c); };
+    assert(parallel_transform_reduce(text.begin(), text.end(), string(), concat, to_string, tiny_grain) == text);
+    (void)concat; (void)to_string;
+
+    // transform_reduce：平方和
+    assert(parallel_transform_reduce(values.begin(), values.begin() + 1000, 0L, plus<>(), [](long x) { return x * x; })
+           == 1000L * 1001 * 2001 / 6);
+
+    // 浮点数：deterministic 模式下与线程数无关，结果逐位相同
+    vector<double> reals(2000000);
+    mt19937_64 rng(7);
+    uniform_real_distribution<double> dist(-1e6, 1e6);
+    for(double& x : reals) x = dist(rng);
+    reduce_options det;
+    det.deterministic = true;
+    double reference = parallel_reduce(reals.begin(), reals.end(), 0.0, plus<>(), det);
+    for(size_t n : {1, 2, 3, 8}) {
+        work_stealing_pool p(n);
+        reduce_options det_pool = det;
+        det_pool.pool = &p;
+        assert(parallel_reduce(reals.begin(), reals.end(), 0.0, plus<>(), det_pool) == reference);
+        (void)det_pool;
+    }
+
+    // 运算中的异常传回调用线程
+    bool thrown = false;
+    try {
+        parallel_reduce(values.begin(), values.end(), 0L, [](long a, long b) {
+            if(b == 777777) throw overflow_error("bad value");
+            return a + b;
+        }, small_grain);
+    } catch(const overflow_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    (void)thrown; (void)expected; (void)reference;
+    cout << "Parallel reduce test passed." << endl;
+}
+
+/*
+    伸缩性基准：对 n 个字节求平方和，n 从 1K 到 1G（需要约 1GB 内存），比较
+    顺序 std::accumulate 式的循环、parallel_accumulate（只能求和，这里直接累加字节值）、
+    parallel_transform_reduce（临时线程 / 线程池 / deterministic），单位 ms/次。
+    n 很小时 parallel_accumulate 仍然每次创建线程，而 parallel_transform_reduce 会退化为顺序计算。
+*/
+void bench_parallel_reduce()
+{
+    const size_t kMaxElements = 1000000000;
+    vector<uint8_t> bytes(kMaxElements);
+    for(size_t i = 0; i < kMaxElements; i++) bytes[i] = static_cast<uint8_t>(i * 131);
+    work_stealing_pool pool;
+    auto square = [](uint8_t x) { return static_cast<uint64_t>(x) * x; };
+    cout << "cpus = " << thread::hardware_concurrency() << endl;
+    for(size_t n = 1000; n <= kMaxElements; n *= 10) {
+        int reps = static_cast<int>(max<size_t>(1, 100000000 / n));
+        auto time_ms = [&](auto&& fn) {
+            volatile uint64_t sink = 0; // 防止结果未被使用而整个计算被优化掉
+            auto start = chrono::steady_clock::now();
+            for(int r = 0; r < reps; r++) sink = sink + fn();
+            return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / reps;
+        };
+        auto last = bytes.begin() + static_cast<ptrdiff_t>(n);
+        reduce_options with_pool, deterministic;
+        with_pool.pool = &pool;
+        deterministic.pool = &pool;
+        deterministic.deterministic = true;
+        cout << "n = " << n
+             << "  sequential: " << time_ms([&]{
+                    uint64_t s = 0;
+                    for(auto it = bytes.begin(); it != last; ++it) s += square(*it);
+                    return s; })
+             << "  parallel_accumulate: " << time_ms([&]{ return parallel_accumulate(bytes.begin(), last, uint64_t(0)); })
+             << "  threads: " << time_ms([&]{ return parallel_transform_reduce(bytes.begin(), last, uint64_t(0), plus<>(), square); })
+             << "  pool: " << time_ms([&]{ return parallel_transform_reduce(bytes.begin(), last, uint64_t(0), plus<>(), square, with_pool); })
+             << "  pool deterministic: " << time_ms([&]{ return parallel_transform_reduce(bytes.begin(), last, uint64_t(0), plus<>(), square, deterministic); })
+             << " ms" << endl;
+    }
+}
+
 int main()
 {
     use_parallel_accumulate();
+    test_thread_pool();
+    // bench_thread_pool();
+    test_parallel_reduce();
+    // bench_parallel_reduce();
 
     return 0;
 }
\ No newline at end of file